@@ -131,6 +131,7 @@ typedef struct {
 	char		 *shared_id;
 	GHashTable	 *shared_exprs;
 	GnmConventions   *convs;
+	GnmCellLoader	 *loader;	/* links the sheet's formulas at the end */
 
 	SheetView	*sv;		/* current sheetview */
 
@@ -1308,12 +1309,9 @@ xlsx_cell_end (GsfXMLIn *xin, G_GNUC_UNUSED GsfXMLBlob *blob)
 			gnm_expr_top_unref (state->texpr);
 			if (NULL != state->val)
 				gnm_cell_assign_value (cell, state->val);
-		} else if (NULL != state->val) {
-			gnm_cell_set_expr_and_value	(cell,
-				state->texpr, state->val, TRUE);
-			gnm_expr_top_unref (state->texpr);
 		} else {
-			gnm_cell_set_expr (cell, state->texpr);
+			gnm_cell_loader_set_expr (state->loader, cell,
+				state->texpr, state->val);
 			gnm_expr_top_unref (state->texpr);
 		}
 		state->texpr = NULL;
@@ -1478,6 +1476,20 @@ xlsx_CT_SheetPr (GsfXMLIn *xin, xmlChar const **attrs)
 #endif
 }
 
+static void
+xlsx_CT_Dimension (GsfXMLIn *xin, xmlChar const **attrs)
+{
+	XLSXReadState *state = (XLSXReadState *)xin->user_state;
+	GnmRange r;
+
+	for (; attrs != NULL && attrs[0] && attrs[1] ; attrs += 2)
+		if (attr_range (xin, attrs, "ref", &r)) {
+			guint64 n = (guint64)range_width (&r) * range_height (&r);
+			gnm_cell_loader_set_size_hint (state->loader,
+				(guint) MIN (n, G_MAXUINT));
+		}
+}
+
 static void
 xlsx_sheet_tabcolor (GsfXMLIn *xin, xmlChar const **attrs)
 {
@@ -2601,7 +2613,7 @@ GSF_XML_IN_NODE_FULL (START, SHEET, XL_NS_SS, "worksheet", GSF_XML_NO_CONTENT, F
     GSF_XML_IN_NODE (PROPS, OUTLINE_PROPS, XL_NS_SS, "outlinePr", GSF_XML_NO_CONTENT, NULL, NULL),
     GSF_XML_IN_NODE (PROPS, TAB_COLOR, XL_NS_SS, "tabColor", GSF_XML_NO_CONTENT, &xlsx_sheet_tabcolor, NULL),
     GSF_XML_IN_NODE (PROPS, PAGE_SETUP, XL_NS_SS, "pageSetUpPr", GSF_XML_NO_CONTENT, &xlsx_sheet_page_setup, NULL),
-  GSF_XML_IN_NODE (SHEET, DIMENSION, XL_NS_SS, "dimension", GSF_XML_NO_CONTENT, NULL, NULL),
+  GSF_XML_IN_NODE (SHEET, DIMENSION, XL_NS_SS, "dimension", GSF_XML_NO_CONTENT, &xlsx_CT_Dimension, NULL),
   GSF_XML_IN_NODE (SHEET, VIEWS, XL_NS_SS, "sheetViews", GSF_XML_NO_CONTENT, NULL, NULL),
     GSF_XML_IN_NODE (VIEWS, VIEW, XL_NS_SS, "sheetView",  GSF_XML_NO_CONTENT, &xlsx_CT_SheetView_begin, &xlsx_CT_SheetView_end),
       GSF_XML_IN_NODE (VIEW, PANE, XL_NS_SS, "pane",  GSF_XML_NO_CONTENT, &xlsx_CT_Pane, NULL),
@@ -3283,7 +3295,10 @@ xlsx_wb_end (GsfXMLIn *xin, G_GNUC_UNUSED GsfXMLBlob *blob)
 
 		cin = gsf_open_pkg_open_rel_by_type (sin,
 			"http://schemas.openxmlformats.org/officeDocument/2006/relationships/comments", NULL);
+		state->loader = gnm_cell_loader_new (state->sheet);
 		xlsx_parse_stream (state, sin, xlsx_sheet_dtd);
+		gnm_cell_loader_finish (state->loader);
+		state->loader = NULL;
 		if (cin != NULL)
 			xlsx_parse_stream (state, cin, xlsx_comments_dtd);
 
@@ -304,6 +304,7 @@ typedef struct {
 	GsfInfile	*zip;		/* Reference to the open file, to load graphs and images*/
 	OOChartInfo	 chart;
 	GnmParsePos	 pos;
+	GnmCellLoader	*loader;	/* links the table's formulas at its end */
 	GnmCellPos	 extent_data;
 	GnmCellPos	 extent_style;
 	GnmComment      *cell_comment;
@@ -1829,6 +1830,7 @@ oo_table_start (GsfXMLIn *xin, xmlChar const **attrs)
 	 * created one out of order */
 	state->sheet_order = g_slist_prepend
 		(state->sheet_order, state->pos.sheet);
+	state->loader = gnm_cell_loader_new (state->pos.sheet);
 
 	if (style_name != NULL) {
 		OOSheetStyle const *style = g_hash_table_lookup (state->styles.sheet, style_name);
@@ -2363,6 +2365,9 @@ oo_table_end (GsfXMLIn *xin, G_GNUC_UNUSED GsfXMLBlob *blob)
 				       sheet_style_default (state->pos.sheet));
 	}
 
+	gnm_cell_loader_finish (state->loader);
+	state->loader = NULL;
+
 	state->pos.eval.col = state->pos.eval.row = 0;
 	state->pos.sheet = NULL;
 }
@@ -2995,11 +3000,8 @@ oo_cell_start (GsfXMLIn *xin, xmlChar const **attrs)
 				 r.end.col - r.start.col + 1,
 				 r.end.row - r.start.row + 1);
 		} else {
-			if (val != NULL)
-				gnm_cell_set_expr_and_value (cell, texpr, val,
-							     TRUE);
-			else
-				gnm_cell_set_expr (cell, texpr);
+			gnm_cell_loader_set_expr (state->loader, cell,
+						  texpr, val);
 			gnm_expr_top_unref (texpr);
 			oo_update_data_extent (state, 1, 1);
 		}
@@ -10082,6 +10084,7 @@ openoffice_file_open (G_GNUC_UNUSED GOFileOpener const *fo, GOIOContext *io_cont
 	state.cur_format.accum = NULL;
 	state.cur_format.percentage = FALSE;
 	state.filter = NULL;
+	state.loader = NULL;
 	state.print.page_breaks.h = state.print.page_breaks.v = NULL;
 	state.last_progress_update = 0;
 	state.last_error = NULL;
@@ -10193,6 +10196,8 @@ openoffice_file_open (G_GNUC_UNUSED GOFileOpener const *fo, GOIOContext *io_cont
 	} else
 		go_io_error_string (io_context, _("XML document not well formed!"));
 	gsf_xml_in_doc_free (doc);
+	/* A table cut short by a parse error still has its loader.  */
+	gnm_cell_loader_finish (state.loader);
 	odf_clear_conventions (&state);
 
 	go_io_progress_unset (state.context);
@@ -236,9 +236,11 @@ gnm_app_clipboard_cut_copy (WorkbookControl *wbc, gboolean is_cut,
 	app->clipboard_cut_range = gnm_range_dup (area);
 	sv_weak_ref (sv, &(app->clipboard_sheet_view));
 
-	if (!is_cut)
+	if (!is_cut) {
+		workbook_recalc_flush (sheet->workbook);
 		app->clipboard_copied_contents =
 			clipboard_copy_range (sheet, area);
+	}
 	if (animate_cursor) {
 		GList *l = g_list_append (NULL, (gpointer)area);
 		sv_ant (sv, l);
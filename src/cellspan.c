@@ -28,26 +28,29 @@
 #include "colrow.h"
 #include "value.h"
 #include "rendered-value.h"
+#include "gnm-cell-tiles.h"
 
-static guint
-col_hash (gconstpointer key)
-{
-	return GPOINTER_TO_INT(key);
-}
-
-static gint
-col_compare (gconstpointer a, gconstpointer b)
-{
-	if (GPOINTER_TO_INT(a) == GPOINTER_TO_INT(b))
-		return 1;
-	return 0;
-}
+/*
+ * The spans of a row are kept in a GArray of CellSpanInfo sorted by
+ * column.  Spans never overlap, so finding the span covering a column is
+ * a binary search and adding or removing one is a single splice.  Rows
+ * without spans have no array.
+ */
 
-static void
-free_hash_value (G_GNUC_UNUSED gpointer key, gpointer value,
-		 G_GNUC_UNUSED gpointer user_data)
+/* The index of the last span starting at or before @col, or -1.  */
+static int
+span_find (GArray const *spans, int col)
 {
-	g_free (value);
+	int lo = 0, hi = (int)spans->len - 1;
+
+	while (lo <= hi) {
+		int const mid = (lo + hi) / 2;
+		if (g_array_index (spans, CellSpanInfo, mid).left <= col)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return hi;
 }
 
 void
@@ -56,8 +59,7 @@ row_destroy_span (ColRowInfo *ri)
 	if (ri == NULL || ri->spans == NULL)
 		return;
 
-	g_hash_table_foreach (ri->spans, free_hash_value, NULL);
-	g_hash_table_destroy (ri->spans);
+	g_array_free (ri->spans, TRUE);
 	ri->spans = NULL;
 }
 
@@ -73,63 +75,59 @@ void
 cell_register_span (GnmCell const *cell, int left, int right)
 {
 	ColRowInfo *ri;
-	int col, i;
+	GArray *spans;
+	CellSpanInfo spaninfo;
+	int i;
 
 	g_return_if_fail (cell != NULL);
 	g_return_if_fail (left <= right);
 
 	ri = cell->row_info;
-	col = cell->pos.col;
 
 	if (left == right)
 		return;
 
 	if (ri->spans == NULL)
-		ri->spans = g_hash_table_new (col_hash, col_compare);
+		ri->spans = g_array_new (FALSE, FALSE, sizeof (CellSpanInfo));
+	spans = ri->spans;
 
-	for (i = left; i <= right; i++){
-		CellSpanInfo *spaninfo = g_new (CellSpanInfo, 1);
+	i = span_find (spans, right);
+	g_return_if_fail (i < 0 ||
+		g_array_index (spans, CellSpanInfo, i).right < left);
 
-		spaninfo->cell  = cell;
-		spaninfo->left  = left;
-		spaninfo->right = right;
-
-		g_return_if_fail (row_span_get (ri, i) == NULL);
-		g_hash_table_insert (ri->spans, GINT_TO_POINTER(i), spaninfo);
-	}
-}
-
-static gboolean
-span_remove (G_GNUC_UNUSED gpointer key, gpointer value,
-	     gpointer user_data)
-{
-	CellSpanInfo *span = (CellSpanInfo *)value;
-	GnmCell *cell = user_data;
-
-	if (cell == span->cell) {
-		g_free (span); /* free the span descriptor */
-		return TRUE;
-	}
-	return FALSE;
+	spaninfo.cell  = cell;
+	spaninfo.left  = left;
+	spaninfo.right = right;
+	g_array_insert_val (spans, i + 1, spaninfo);
 }
 
 /*
  * sheet_cell_unregister_span
  * @cell: The cell to remove from the span information
  *
- * Remove all references to this cell in the span hashtable
+ * Remove all references to this cell in the span information.  A span
+ * always covers the column of its cell.
  */
 void
 cell_unregister_span (GnmCell const * const cell)
 {
+	GArray *spans;
+	int i;
+
 	g_return_if_fail (cell != NULL);
 	g_return_if_fail (cell->row_info != NULL);
 
-	if (cell->row_info->spans == NULL)
+	spans = cell->row_info->spans;
+	if (spans == NULL)
 		return;
 
-	g_hash_table_foreach_remove (cell->row_info->spans,
-		&span_remove, (gpointer)cell);
+	i = span_find (spans, cell->pos.col);
+	if (i < 0 || g_array_index (spans, CellSpanInfo, i).cell != cell)
+		return;
+
+	g_array_remove_index (spans, i);
+	if (spans->len == 0)
+		row_destroy_span (cell->row_info);
 }
 
 /*
@@ -141,15 +139,23 @@ cell_unregister_span (GnmCell const * const cell)
  * column.  Including
  *   - the cell whose contents span.
  *   - The first and last col in the span.
+ * The result is only valid until the spans of the row change.
  */
 CellSpanInfo const *
 row_span_get (ColRowInfo const * const ri, int const col)
 {
+	CellSpanInfo const *span;
+	int i;
+
 	g_return_val_if_fail (ri != NULL, NULL);
 
 	if (ri->spans == NULL)
 		return NULL;
-	return g_hash_table_lookup (ri->spans, GINT_TO_POINTER(col));
+	i = span_find (ri->spans, col);
+	if (i < 0)
+		return NULL;
+	span = &g_array_index ((GArray *)ri->spans, CellSpanInfo, i);
+	return (span->right >= col) ? span : NULL;
 }
 
 /**
@@ -390,17 +396,17 @@ cell_calc_span (GnmCell const *cell, int *col1, int *col2)
 	} /* switch */
 }
 
-void
-row_calc_spans (ColRowInfo *ri, int row, Sheet const *sheet)
+static void
+row_calc_spans_band (ColRowInfo *ri, int row, Sheet const *sheet,
+		     GnmCellTilesBand *band, int last)
 {
 	int left, right, col;
 	GnmRange const *merged;
 	GnmCell *cell;
-	int const last = sheet->cols.max_used;
 
 	row_destroy_span (ri);
 	for (col = 0 ; col <= last ; ) {
-		cell = sheet_cell_get (sheet, col, row);
+		cell = gnm_cell_tiles_band_get (band, col, row);
 		if (cell == NULL) {
 			/* skip segments with no cells */
 			if (col == COLROW_SEGMENT_START (col) &&
@@ -432,3 +438,49 @@ row_calc_spans (ColRowInfo *ri, int row, Sheet const *sheet)
 
 	ri->needs_respan = FALSE;
 }
+
+void
+row_calc_spans (ColRowInfo *ri, int row, Sheet const *sheet)
+{
+	int const last = sheet->cols.max_used;
+	GnmCellTilesBand band;
+
+	if (last < 0) {
+		row_destroy_span (ri);
+		ri->needs_respan = FALSE;
+		return;
+	}
+
+	gnm_cell_tiles_band_init (&band, sheet->cell_tiles, 0, last);
+	row_calc_spans_band (ri, row, sheet, &band, last);
+	gnm_cell_tiles_band_clear (&band);
+}
+
+/**
+ * rows_calc_spans :
+ * @sheet :
+ * @start_row :
+ * @end_row :
+ *
+ * Recomputes the spans of the visible rows from @start_row to @end_row
+ * that need it.  Neighbouring rows share their cell lookups, so this is
+ * cheaper than calling row_calc_spans on each.
+ **/
+void
+rows_calc_spans (Sheet const *sheet, int start_row, int end_row)
+{
+	int const last = sheet->cols.max_used;
+	GnmCellTilesBand band;
+	int row;
+
+	if (last < 0)
+		return;
+
+	gnm_cell_tiles_band_init (&band, sheet->cell_tiles, 0, last);
+	for (row = start_row; row <= end_row; row++) {
+		ColRowInfo *ri = sheet_row_get (sheet, row);
+		if (ri != NULL && ri->visible && ri->needs_respan)
+			row_calc_spans_band (ri, row, sheet, &band, last);
+	}
+	gnm_cell_tiles_band_clear (&band);
+}
@@ -20,6 +20,8 @@ void cell_unregister_span  (GnmCell const *cell);
 CellSpanInfo const *row_span_get     (ColRowInfo const *ri, int col);
 void		    row_destroy_span (ColRowInfo *ri);
 void		    row_calc_spans   (ColRowInfo *ri, int row, Sheet const *sheet);
+void		    rows_calc_spans  (Sheet const *sheet,
+				      int start_row, int end_row);
 
 G_END_DECLS
 
@@ -296,6 +296,9 @@ cmd_paste (WorkbookControl *wbc, GnmPasteTarget const *pt)
 	g_return_if_fail (pt != NULL);
 	g_return_if_fail (IS_SHEET (pt->sheet));
 
+	/* Finish any pending incremental recalc before reading values.  */
+	workbook_recalc_flush (pt->sheet->workbook);
+
 	src_range = gnm_app_clipboard_area_get ();
 	content = gnm_app_clipboard_contents_get ();
 
@@ -622,6 +622,7 @@ colrow_set_states (Sheet *sheet, gboolean is_cols,
 		}
 		offset += rles->length;
 	}
+	colrow_sizes_changed (infos, first);
 
 	/* Notify sheet of pending update */
 	sheet->priv->recompute_visibility = TRUE;
@@ -1102,6 +1103,7 @@ colrow_set_visibility (Sheet *sheet, gboolean is_cols,
 		changed = (visible == 0) != (cri->visible == 0);
 		if (changed) {
 			cri->visible = visible;
+			colrow_sizes_changed (is_cols ? &sheet->cols : &sheet->rows, i);
 			prev_outline = cri->outline_level;
 			sheet->priv->recompute_visibility = TRUE;
 
@@ -1215,4 +1217,227 @@ colrow_resize (ColRowCollection *infos, int size)
 	}
 
 	g_ptr_array_set_size (infos->info, end_idx);
+
+	/* One more than there are segments, for the far end.  */
+	infos->start_pts = g_renew (double, infos->start_pts, end_idx + 1);
+	infos->start_pixels = g_renew (gint64, infos->start_pixels, end_idx + 1);
+	if (infos->n_valid > end_idx + 1)
+		infos->n_valid = end_idx + 1;
+}
+
+/*
+ * Distances are looked up far more often than sizes change, and changes
+ * come in bursts (a paste, a load, a zoom).  Rather than keeping a tree up
+ * to date on every change we keep the distance to the start of each
+ * segment, and a change only forgets the entries after it.  The next
+ * query sums the forgotten segments once and a query within a segment
+ * adds up at most COLROW_SEGMENT_SIZE entries.
+ */
+
+/**
+ * colrow_sizes_changed :
+ * @infos :
+ * @first : the lowest index whose size or visibility changed
+ *
+ * Must be called whenever an entry is added, removed, resized, shown or
+ * hidden, and with 0 when the default size changes.
+ **/
+void
+colrow_sizes_changed (ColRowCollection *infos, int first)
+{
+	int const n = COLROW_SEGMENT_INDEX (MAX (first, 0)) + 1;
+	if (infos->n_valid > n)
+		infos->n_valid = n;
+}
+
+static void
+colrow_validate_starts (ColRowCollection const *cinfos, int seg)
+{
+	/* The cache is not part of the value of the collection.  */
+	ColRowCollection *infos = (ColRowCollection *)cinfos;
+	double const dflt_pts = infos->default_style.size_pts;
+	int const dflt_pixels = infos->default_style.size_pixels;
+	int k;
+
+	if (seg < infos->n_valid)
+		return;
+
+	if (infos->n_valid == 0) {
+		infos->start_pts[0] = 0.;
+		infos->start_pixels[0] = 0;
+		infos->n_valid = 1;
+	}
+
+	for (k = infos->n_valid; k <= seg; k++) {
+		ColRowSegment const *segment =
+			g_ptr_array_index (infos->info, k - 1);
+		double pts;
+		gint64 pixels;
+
+		if (segment == NULL) {
+			pts = dflt_pts * COLROW_SEGMENT_SIZE;
+			pixels = (gint64)dflt_pixels * COLROW_SEGMENT_SIZE;
+		} else {
+			int i;
+			pts = 0.;
+			pixels = 0;
+			for (i = 0; i < COLROW_SEGMENT_SIZE; i++) {
+				ColRowInfo const *cri = segment->info[i];
+				if (cri == NULL) {
+					pts += dflt_pts;
+					pixels += dflt_pixels;
+				} else if (cri->visible) {
+					pts += cri->size_pts;
+					pixels += cri->size_pixels;
+				}
+			}
+		}
+
+		infos->start_pts[k] = infos->start_pts[k - 1] + pts;
+		infos->start_pixels[k] = infos->start_pixels[k - 1] + pixels;
+	}
+	infos->n_valid = seg + 1;
+}
+
+static double
+colrow_start_pts (ColRowCollection const *infos, int pos)
+{
+	int const seg = COLROW_SEGMENT_INDEX (pos);
+	ColRowSegment const *segment;
+	double pts;
+	int i;
+
+	colrow_validate_starts (infos, seg);
+	pts = infos->start_pts[seg];
+	if (COLROW_SUB_INDEX (pos) == 0)
+		return pts;
+
+	segment = g_ptr_array_index (infos->info, seg);
+	if (segment == NULL)
+		return pts + infos->default_style.size_pts * COLROW_SUB_INDEX (pos);
+	for (i = COLROW_SEGMENT_START (pos); i < pos; i++) {
+		ColRowInfo const *cri = segment->info[COLROW_SUB_INDEX (i)];
+		if (cri == NULL)
+			pts += infos->default_style.size_pts;
+		else if (cri->visible)
+			pts += cri->size_pts;
+	}
+	return pts;
+}
+
+static gint64
+colrow_start_pixels (ColRowCollection const *infos, int pos)
+{
+	int const seg = COLROW_SEGMENT_INDEX (pos);
+	ColRowSegment const *segment;
+	gint64 pixels;
+	int i;
+
+	colrow_validate_starts (infos, seg);
+	pixels = infos->start_pixels[seg];
+	if (COLROW_SUB_INDEX (pos) == 0)
+		return pixels;
+
+	segment = g_ptr_array_index (infos->info, seg);
+	if (segment == NULL)
+		return pixels + (gint64)infos->default_style.size_pixels *
+			COLROW_SUB_INDEX (pos);
+	for (i = COLROW_SEGMENT_START (pos); i < pos; i++) {
+		ColRowInfo const *cri = segment->info[COLROW_SUB_INDEX (i)];
+		if (cri == NULL)
+			pixels += infos->default_style.size_pixels;
+		else if (cri->visible)
+			pixels += cri->size_pixels;
+	}
+	return pixels;
+}
+
+/**
+ * colrow_get_distance_pts :
+ * @infos :
+ * @from :
+ * @to : at most the number of entries in @infos
+ *
+ * Returns the number of pts from the start of @from to the start of @to,
+ * negative if @to comes first.  Hidden entries take no space.
+ **/
+double
+colrow_get_distance_pts (ColRowCollection const *infos, int from, int to)
+{
+	if (from == to)
+		return 0.;
+	return colrow_start_pts (infos, to) - colrow_start_pts (infos, from);
+}
+
+/**
+ * colrow_get_distance_pixels :
+ * @infos :
+ * @from :
+ * @to : at most the number of entries in @infos
+ *
+ * As colrow_get_distance_pts but in pixels.
+ **/
+gint64
+colrow_get_distance_pixels (ColRowCollection const *infos, int from, int to)
+{
+	if (from == to)
+		return 0;
+	return colrow_start_pixels (infos, to) - colrow_start_pixels (infos, from);
+}
+
+/**
+ * colrow_find_pixel :
+ * @infos :
+ * @pixel : distance from the start of @infos
+ * @origin : optionally return the distance to the start of the result
+ *
+ * Returns the entry that ends at or after @pixel, skipping hidden entries.
+ * Anything before the start gives the first entry and anything past the
+ * end the last.
+ **/
+int
+colrow_find_pixel (ColRowCollection const *infos, gint64 pixel, gint64 *origin)
+{
+	int const n_segs = infos->info->len;
+	int lo = 0, hi = n_segs - 1, i, end;
+	ColRowSegment const *segment;
+	gint64 start;
+
+	g_return_val_if_fail (n_segs > 0, 0);
+
+	/* The last segment starting before @pixel, or the first one.  */
+	colrow_validate_starts (infos, n_segs);
+	while (lo < hi) {
+		int const mid = (lo + hi + 1) / 2;
+		if (infos->start_pixels[mid] < pixel)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+
+	start = infos->start_pixels[lo];
+	segment = g_ptr_array_index (infos->info, lo);
+	end = (lo + 1) * COLROW_SEGMENT_SIZE;
+	for (i = lo * COLROW_SEGMENT_SIZE; i < end; i++) {
+		int size;
+		if (segment == NULL || segment->info[COLROW_SUB_INDEX (i)] == NULL)
+			size = infos->default_style.size_pixels;
+		else if (segment->info[COLROW_SUB_INDEX (i)]->visible)
+			size = segment->info[COLROW_SUB_INDEX (i)]->size_pixels;
+		else
+			continue;
+		if (pixel <= start + size)
+			break;
+		start += size;
+	}
+
+	if (i >= end) {
+		/* Past the end.  */
+		i = n_segs * COLROW_SEGMENT_SIZE - 1;
+		start = colrow_start_pixels (infos, i);
+	}
+
+	if (origin)
+		*origin = start;
+	return i;
 }
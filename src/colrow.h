@@ -30,6 +30,12 @@ struct _ColRowCollection {
 	ColRowInfo  default_style;
 	GPtrArray * info;
 	int	    max_outline_level;
+
+	/* Distance from the start of the collection to each segment, valid
+	 * for the first n_valid segments.  See colrow_sizes_changed.  */
+	double	   *start_pts;
+	gint64	   *start_pixels;
+	int	    n_valid;
 };
 
 /* We never did get around to support 'thick' borders so these are effectively
@@ -93,6 +99,13 @@ gboolean colrow_foreach	   (ColRowCollection const *infos,
 			    gpointer user_data);
 
 void colrow_resize (ColRowCollection *infos, int size);
+void colrow_sizes_changed (ColRowCollection *infos, int first);
+double colrow_get_distance_pts	  (ColRowCollection const *infos,
+				   int from, int to);
+gint64 colrow_get_distance_pixels (ColRowCollection const *infos,
+				   int from, int to);
+int    colrow_find_pixel	  (ColRowCollection const *infos,
+				   gint64 pixel, gint64 *origin);
 
 #define colrow_index_list_destroy(l) go_list_free_custom ((l), g_free)
 
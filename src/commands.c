@@ -342,8 +342,13 @@ update_after_action (Sheet *sheet, WorkbookControl *wbc)
 		g_return_if_fail (IS_SHEET (sheet));
 
 		sheet_mark_dirty (sheet);
-		if (workbook_get_recalcmode (sheet->workbook))
-			workbook_recalc (sheet->workbook);
+		if (workbook_get_recalcmode (sheet->workbook)) {
+			/* Only a gui has a main loop to finish the job.  */
+			if (IS_WBC_GTK (wbc))
+				workbook_recalc_incremental (sheet->workbook);
+			else
+				workbook_recalc (sheet->workbook);
+		}
 		sheet_update (sheet);
 
 		if (sheet->workbook == wb_control_get_workbook (wbc))
@@ -357,6 +362,24 @@ update_after_action (Sheet *sheet, WorkbookControl *wbc)
 }
 
 
+/*
+ * A gui leaves recalculation to idle slices (see update_after_action), so
+ * cells may still hold stale values when the next command starts.  Finish
+ * that recalc first; commands such as sort, filter, and paste read computed
+ * values.
+ */
+static void
+command_flush_recalc (WorkbookControl *wbc, Sheet *sheet)
+{
+	Workbook *wb = wb_control_get_workbook (wbc);
+
+	if (wb != NULL)
+		workbook_recalc_flush (wb);
+	if (sheet != NULL && sheet->workbook != wb)
+		workbook_recalc_flush (sheet->workbook);
+}
+
+
 /**
  * command_undo : Undo the last command executed.
  * @wbc : The workbook control which issued the request.
@@ -383,6 +406,8 @@ command_undo (WorkbookControl *wbc)
 
 	g_object_ref (cmd);
 
+	command_flush_recalc (wbc, cmd->sheet);
+
 	/* TRUE indicates a failure to undo.  Leave the command where it is */
 	if (!klass->undo_cmd (cmd, wbc)) {
 		gboolean undo_cleared;
@@ -441,6 +466,8 @@ command_redo (WorkbookControl *wbc)
 	cmd->workbook_modified_before_do =
 		go_doc_is_dirty (wb_control_get_doc (wbc));
 
+	command_flush_recalc (wbc, cmd->sheet);
+
 	/* TRUE indicates a failure to redo.  Leave the command where it is */
 	if (!klass->redo_cmd (cmd, wbc)) {
 		gboolean redo_cleared;
@@ -697,6 +724,8 @@ gnm_command_push_undo (WorkbookControl *wbc, GObject *obj)
 	klass = CMD_CLASS (cmd);
 	g_return_val_if_fail (klass != NULL, TRUE);
 
+	command_flush_recalc (wbc, cmd->sheet);
+
 	/* TRUE indicates a failure to do the command */
 	trouble = klass->redo_cmd (cmd, wbc);
 	update_after_action (cmd->sheet, wbc);
@@ -4376,6 +4405,9 @@ cmd_search_replace (WorkbookControl *wbc, GnmSearchReplace *sr)
 
 	g_return_val_if_fail (sr != NULL, TRUE);
 
+	/* Searching matches computed values and bypasses push_undo.  */
+	command_flush_recalc (wbc, NULL);
+
 	me = g_object_new (CMD_SEARCH_REPLACE_TYPE, NULL);
 
 	me->cells = NULL;
@@ -5363,7 +5395,7 @@ cmd_analysis_tool_finalize (GObject *cmd)
  * succeeds.
  */
 gboolean
-cmd_analysis_tool (WorkbookControl *wbc, G_GNUC_UNUSED Sheet *sheet,
+cmd_analysis_tool (WorkbookControl *wbc, Sheet *sheet,
 		   data_analysis_output_t *dao, gpointer specs,
 		   analysis_tool_engine engine, gboolean always_take_ownership)
 {
@@ -5374,6 +5406,9 @@ cmd_analysis_tool (WorkbookControl *wbc, G_GNUC_UNUSED Sheet *sheet,
 	g_return_val_if_fail (specs != NULL, TRUE);
 	g_return_val_if_fail (engine != NULL, TRUE);
 
+	/* The engine is consulted before the command is pushed.  */
+	command_flush_recalc (wbc, sheet);
+
 	me = g_object_new (CMD_ANALYSIS_TOOL_TYPE, NULL);
 
 	dao->wbc = wbc;
@@ -37,12 +37,21 @@
 #include "gutils.h"
 #include "sheet-view.h"
 #include "func.h"
+#include "gnm-rtree.h"
+#include "expr-code.h"
+#include "recalc-profile.h"
 
 #include <goffice/goffice.h>
 #include <string.h>
 
 static void dependent_changed (GnmDependent *dep);
 static void dependent_clear_dynamic_deps (GnmDependent *dep);
+static void dependent_begin_dynamic_deps (GnmDependent *dep);
+static void dependent_end_dynamic_deps (GnmDependent *dep);
+
+/* Parallel recalc, see workbook_recalc.  */
+static int recalc_threads = 1;
+static GThreadPool *recalc_pool = NULL;
 
 /* ------------------------------------------------------------------------- */
 
@@ -73,14 +82,6 @@ static GOMemChunk *cset_pool;
 #define FREE_FEW(p) g_slice_free1 (MICRO_HASH_FEW * sizeof (gpointer), p)
 #endif
 
-/* ------------------------------------------------------------------------- */
-/* Maps between row numbers and bucket numbers.  */
-
-#define BUCKET_SIZE	128
-#define BUCKET_OF_ROW(row) ((row) / BUCKET_SIZE)
-#define BUCKET_START_ROW(b) ((b) * BUCKET_SIZE)
-#define BUCKET_END_ROW(b) ((b) * BUCKET_SIZE + (BUCKET_SIZE - 1))
-
 /* ------------------------------------------------------------------------- */
 
 /* Keep this odd */
@@ -259,6 +260,17 @@ typedef struct {
 	GnmDependent *container;
 	GSList    *ranges;
 	GSList    *singles;
+
+	/* While the container is being evaluated, the links made by the
+	 * previous evaluation.  Those asked for again are in the lists
+	 * above too.  */
+	GSList    *old_ranges;
+	GSList    *old_singles;
+
+	/* Maps every linked GnmRangeRef to the evaluation that last
+	 * asked for it.  */
+	GHashTable *requested;
+	guint	    generation;
 } DynamicDep;
 
 void
@@ -293,6 +305,11 @@ dependent_types_shutdown (void)
 	g_ptr_array_free (dep_classes, TRUE);
 	dep_classes = NULL;
 
+	if (recalc_pool != NULL) {
+		g_thread_pool_free (recalc_pool, FALSE, TRUE);
+		recalc_pool = NULL;
+	}
+
 #if USE_POOLS
 	go_mem_chunk_destroy (micro_few_pool, FALSE);
 	micro_few_pool = NULL;
@@ -323,15 +340,74 @@ dependent_type_register (GnmDependentClass const *klass)
 	return res;
 }
 
+static inline void
+dep_container_note_dirty (GnmDepContainer *deps, GnmCellPos const *pos)
+{
+	GnmRange *r = &deps->dirty_area;
+
+	if (!deps->has_dirty_area) {
+		range_init_cellpos (r, pos);
+		deps->has_dirty_area = TRUE;
+	} else {
+		if (pos->col < r->start.col) r->start.col = pos->col;
+		if (pos->col > r->end.col)   r->end.col   = pos->col;
+		if (pos->row < r->start.row) r->start.row = pos->row;
+		if (pos->row > r->end.row)   r->end.row   = pos->row;
+	}
+}
+
+/* Could a cell in @r need a recalc ?  */
+static inline gboolean
+dep_container_may_be_dirty (GnmDepContainer const *deps, GnmRange const *r)
+{
+	return deps->has_dirty_area && range_overlap (&deps->dirty_area, r);
+}
+
+/* Once the dirty set is empty no cell of @deps needs a recalc.  */
+static void
+dep_container_check_clean (GnmDepContainer *deps)
+{
+	if (g_hash_table_size (deps->dirty) == 0)
+		deps->has_dirty_area = FALSE;
+}
+
 /*
  * dependent_flag_recalc:
  * @dep: the dependent that contains the expression needing recomputation.
  *
- * Marks @dep as needing recalculation
+ * Marks @dep as needing recalculation and, if it is linked, records it in
+ * its container's dirty set so that workbook_recalc can find it without
+ * scanning every dependent.
  * NOTE : it does NOT recursively dirty dependencies.
  */
-#define dependent_flag_recalc(dep) \
-  do { (dep)->flags |= DEPENDENT_NEEDS_RECALC; } while (0)
+static inline void
+dependent_flag_recalc (GnmDependent *dep)
+{
+	dep->flags |= DEPENDENT_NEEDS_RECALC;
+	dep->flags &= ~DEPENDENT_CHECK_INPUTS;
+	if (dep->sheet == NULL || dep->sheet->deps == NULL)
+		return;
+	if (dependent_is_cell (dep))
+		dep_container_note_dirty (dep->sheet->deps,
+					  &GNM_DEP_TO_CELL (dep)->pos);
+	if (dependent_is_linked (dep))
+		g_hash_table_insert (dep->sheet->deps->dirty, dep, dep);
+}
+
+/*
+ * dependent_flag_changed:
+ * @dep: a dependent whose input definitely changed.
+ *
+ * Like dependent_flag_recalc but returns TRUE if @dep was not already
+ * queued, in which case its dependents still need to be queued.
+ */
+static inline gboolean
+dependent_flag_changed (GnmDependent *dep)
+{
+	gboolean queued = dependent_needs_recalc (dep);
+	dependent_flag_recalc (dep);
+	return !queued;
+}
 
 /**
  * dependent_changed:
@@ -442,6 +518,12 @@ dependent_queue_recalc_main (GSList *work)
 	 * to be marked.  Marking early guarentees that we will not
 	 * get duplicates.  (And it thus limits the length of the list.)
 	 * We treat work as a stack.
+	 *
+	 * The dependents found here are only flagged DEPENDENT_CHECK_INPUTS:
+	 * their recalc is skipped unless evaluating a precedent produces a
+	 * new value (see cell_assign_computed_value).  A cell that will not
+	 * be evaluated itself cannot report that, so its dependents get a
+	 * full recalc.
 	 */
 
 	while (work) {
@@ -454,6 +536,8 @@ dependent_queue_recalc_main (GSList *work)
 		g_slist_free_1 (list);
 
 		if (t == DEPENDENT_CELL) {
+			gboolean check = dependent_is_linked (dep) &&
+				gnm_cell_has_expr (GNM_DEP_TO_CELL (dep));
 			GSList *deps = cell_list_deps (GNM_DEP_TO_CELL (dep));
 			GSList *waste = NULL;
 			GSList *next;
@@ -461,10 +545,14 @@ dependent_queue_recalc_main (GSList *work)
 				GnmDependent *dep = list->data;
 				next = list->next;
 				if (dependent_needs_recalc (dep)) {
+					if (!check)
+						dep->flags &= ~DEPENDENT_CHECK_INPUTS;
 					list->next = waste;
 					waste = list;
 				} else {
 					dependent_flag_recalc (dep);
+					if (check)
+						dep->flags |= DEPENDENT_CHECK_INPUTS;
 					list->next = work;
 					work = list;
 				}
@@ -495,10 +583,8 @@ dependent_queue_recalc_list (GSList *list)
 
 	for (; list != NULL ; list = list->next) {
 		GnmDependent *dep = list->data;
-		if (!dependent_needs_recalc (dep)) {
-			dependent_flag_recalc (dep);
+		if (dependent_flag_changed (dep))
 			work = g_slist_prepend (work, dep);
-		}
 	}
 
 	dependent_queue_recalc_main (work);
@@ -517,7 +603,8 @@ dependent_queue_recalc (GnmDependent *dep)
 		listrec.next = NULL;
 		listrec.data = dep;
 		dependent_queue_recalc_list (&listrec);
-	}
+	} else
+		dependent_flag_recalc (dep);
 }
 
 /**************************************************************************/
@@ -748,6 +835,46 @@ micro_hash_release (MicroHash *hash_table)
 	hash_table->u.one = NULL;
 }
 
+/*
+ * Buckets only ever grow and removals leave holes in the segments.  Rehash
+ * into as few buckets as keep the chains to about one segment, which also
+ * packs the segments.
+ */
+static void
+micro_hash_compact (MicroHash *hash_table)
+{
+	int N = hash_table->num_elements;
+	int new_nbuckets;
+
+	if (N <= MICRO_HASH_FEW)
+		return;
+
+	new_nbuckets = g_spaced_primes_closest (N * 3 / (CSET_SEGMENT_SIZE * 2));
+	new_nbuckets = CLAMP (new_nbuckets, 1, MICRO_HASH_MAX_SIZE);
+	micro_hash_many_resize (hash_table, new_nbuckets);
+}
+
+static gsize
+micro_hash_get_memory (MicroHash const *hash_table)
+{
+	int N = hash_table->num_elements;
+	gsize res;
+	int i;
+
+	if (N <= 1)
+		return 0;
+	if (N <= MICRO_HASH_FEW)
+		return MICRO_HASH_FEW * sizeof (gpointer);
+
+	res = hash_table->num_buckets * sizeof (CSet *);
+	for (i = 0; i < hash_table->num_buckets; i++) {
+		CSet const *cs;
+		for (cs = hash_table->u.many[i]; cs != NULL; cs = cs->next)
+			res += sizeof (CSet);
+	}
+	return res;
+}
+
 static void
 micro_hash_init (MicroHash *hash_table, gpointer key)
 {
@@ -782,8 +909,10 @@ micro_hash_is_empty (MicroHash const *hash_table)
 /**************************************************************************
  * Data structures for managing dependencies between objects.
  *
- * The DependencyRange hash needs to be improved.  It is a huge
- * performance hit when there are large numbers of range depends.
+ * Each distinct range that something depends on gets one DependencyRange.
+ * They are kept in a hash for duplicate culling and in an R-tree so that
+ * the ranges containing a given cell can be found without looking at all
+ * of them.
  */
 
 /*
@@ -893,68 +1022,221 @@ unlink_single_dep (GnmDependent *dep, GnmCellPos const *pos, GnmCellRef const *a
 	}
 }
 
+/*
+ * Whole column references like A:A are common in imported files.  In
+ * range_tree they would all share the full height, which makes every
+ * lookup visit all of them.  Instead they are indexed on their columns
+ * only; the row of the key is always 0.  Whole rows likewise.
+ */
+typedef enum {
+	DEPRANGE_PLAIN,
+	DEPRANGE_WHOLE_COLS,
+	DEPRANGE_WHOLE_ROWS
+} DepRangeKind;
+
+static DepRangeKind
+deprange_kind (GnmDepContainer const *deps, GnmRange const *r)
+{
+	if (r->start.row == 0 && r->end.row >= deps->max_rows - 1)
+		return DEPRANGE_WHOLE_COLS;
+	if (r->start.col == 0 && r->end.col >= deps->max_cols - 1)
+		return DEPRANGE_WHOLE_ROWS;
+	return DEPRANGE_PLAIN;
+}
+
 static void
-link_range_dep (GnmDepContainer *deps, GnmDependent *dep,
-		DependencyRange const *r)
+deprange_index (GnmDepContainer *deps, DependencyRange *dr)
 {
-	int i = BUCKET_OF_ROW (r->range.start.row);
-	int const end = BUCKET_OF_ROW (r->range.end.row);
-	DependencyRange r2 = *r;
+	GnmRange key;
 
-	for ( ; i <= end; i++) {
-		DependencyRange *result;
+	switch (deprange_kind (deps, &dr->range)) {
+	case DEPRANGE_WHOLE_COLS:
+		range_init (&key, dr->range.start.col, 0, dr->range.end.col, 0);
+		gnm_rtree_insert (deps->col_tree, &key, dr);
+		break;
+	case DEPRANGE_WHOLE_ROWS:
+		range_init (&key, 0, dr->range.start.row, 0, dr->range.end.row);
+		gnm_rtree_insert (deps->row_tree, &key, dr);
+		break;
+	default:
+		gnm_rtree_insert (deps->range_tree, &dr->range, dr);
+	}
+}
 
-		/* Restrict range to bucket.  */
-		r2.range.start.row = MAX (r->range.start.row, BUCKET_START_ROW (i));
-		r2.range.end.row = MIN (r->range.end.row, BUCKET_END_ROW (i));
+static void
+deprange_unindex (GnmDepContainer *deps, DependencyRange *dr)
+{
+	switch (deprange_kind (deps, &dr->range)) {
+	case DEPRANGE_WHOLE_COLS:
+		gnm_rtree_remove (deps->col_tree, dr);
+		break;
+	case DEPRANGE_WHOLE_ROWS:
+		gnm_rtree_remove (deps->row_tree, dr);
+		break;
+	default:
+		gnm_rtree_remove (deps->range_tree, dr);
+	}
+}
 
-		if (deps->range_hash[i] == NULL)
-			deps->range_hash[i] = g_hash_table_new (
-				(GHashFunc)  deprange_hash,
-				(GEqualFunc) deprange_equal);
-		else {
-			result = g_hash_table_lookup (deps->range_hash[i], &r2);
-			if (result) {
-				/* Inserts if it is not already there */
-				micro_hash_insert (&result->deps, dep);
-				continue;
-			}
-		}
+static void
+dep_container_begin_batch (GnmDepContainer *deps)
+{
+	gnm_rtree_begin_batch (deps->range_tree);
+	gnm_rtree_begin_batch (deps->col_tree);
+	gnm_rtree_begin_batch (deps->row_tree);
+}
+
+static void
+dep_container_end_batch (GnmDepContainer *deps)
+{
+	gnm_rtree_end_batch (deps->range_tree);
+	gnm_rtree_end_batch (deps->col_tree);
+	gnm_rtree_end_batch (deps->row_tree);
+}
+
+/*
+ * Relinking or invalidating many dependents adds and removes range records
+ * in the containers of every sheet they refer to.  Batch those so that each
+ * index is packed once at the end rather than after every change.  @wbs
+ * collects the workbooks whose sheets are in the batch.
+ */
+static GSList *
+deps_batch_begin (GSList *wbs, Workbook *wb)
+{
+	if (wb == NULL || g_slist_find (wbs, wb) != NULL)
+		return wbs;
+
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		if (sheet->deps != NULL)
+			dep_container_begin_batch (sheet->deps);
+	});
+	return g_slist_prepend (wbs, wb);
+}
+
+/* Containers destroyed within the batch are skipped.  */
+static void
+deps_batch_end (GSList *wbs)
+{
+	GSList *l;
+
+	for (l = wbs; l != NULL; l = l->next) {
+		Workbook *wb = l->data;
+		WORKBOOK_FOREACH_SHEET (wb, sheet, {
+			if (sheet->deps != NULL)
+				dep_container_end_batch (sheet->deps);
+		});
+	}
+	g_slist_free (wbs);
+}
+
+/**
+ * dependents_batch_begin :
+ * @wb :
+ *
+ * Start batching changes to the dependency containers of @wb's sheets,
+ * for callers that link many dependents one at a time.  Must be matched
+ * by dependents_batch_end, with no sheets added to @wb in between.
+ **/
+void
+dependents_batch_begin (Workbook *wb)
+{
+	g_return_if_fail (IS_WORKBOOK (wb));
+	deps_batch_begin (NULL, wb);
+}
+
+void
+dependents_batch_end (Workbook *wb)
+{
+	g_return_if_fail (IS_WORKBOOK (wb));
+	deps_batch_end (g_slist_prepend (NULL, wb));
+}
+
+typedef struct {
+	GnmRTreeFunc func;
+	gpointer     user;
+} DepRangeTrampoline;
+
+/* Hand the callback the real range, not the key.  */
+static void
+cb_deprange_trampoline (DependencyRange *dr,
+			G_GNUC_UNUSED GnmRange const *key,
+			DepRangeTrampoline *t)
+{
+	t->func (dr, &dr->range, t->user);
+}
+
+static void
+deps_foreach_range_containing (GnmDepContainer const *deps,
+			       int col, int row,
+			       GnmRTreeFunc func, gpointer user)
+{
+	DepRangeTrampoline t;
+
+	t.func = func;
+	t.user = user;
+	gnm_rtree_foreach_containing (deps->range_tree, col, row, func, user);
+	gnm_rtree_foreach_containing (deps->col_tree, col, 0,
+		(GnmRTreeFunc) cb_deprange_trampoline, &t);
+	gnm_rtree_foreach_containing (deps->row_tree, 0, row,
+		(GnmRTreeFunc) cb_deprange_trampoline, &t);
+}
+
+static void
+deps_foreach_range_overlapping (GnmDepContainer const *deps,
+				GnmRange const *r,
+				GnmRTreeFunc func, gpointer user)
+{
+	DepRangeTrampoline t;
+	GnmRange key;
+
+	t.func = func;
+	t.user = user;
+	gnm_rtree_foreach_overlapping (deps->range_tree, r, func, user);
+	range_init (&key, r->start.col, 0, r->end.col, 0);
+	gnm_rtree_foreach_overlapping (deps->col_tree, &key,
+		(GnmRTreeFunc) cb_deprange_trampoline, &t);
+	range_init (&key, 0, r->start.row, 0, r->end.row);
+	gnm_rtree_foreach_overlapping (deps->row_tree, &key,
+		(GnmRTreeFunc) cb_deprange_trampoline, &t);
+}
+
+static void
+link_range_dep (GnmDepContainer *deps, GnmDependent *dep,
+		DependencyRange const *r)
+{
+	DependencyRange *result = g_hash_table_lookup (deps->range_hash, r);
 
-		/* Create a new DependencyRange structure */
-		result = go_mem_chunk_alloc (deps->range_pool);
-		*result = r2;
-		micro_hash_init (&result->deps, dep);
-		g_hash_table_insert (deps->range_hash[i], result, result);
+	if (result) {
+		/* Inserts if it is not already there */
+		micro_hash_insert (&result->deps, dep);
+		return;
 	}
+
+	/* Create a new DependencyRange structure */
+	result = go_mem_chunk_alloc (deps->range_pool);
+	*result = *r;
+	micro_hash_init (&result->deps, dep);
+	g_hash_table_insert (deps->range_hash, result, result);
+	deprange_index (deps, result);
 }
 
 static void
 unlink_range_dep (GnmDepContainer *deps, GnmDependent *dep,
 		  DependencyRange const *r)
 {
-	int i = BUCKET_OF_ROW (r->range.start.row);
-	int const end = BUCKET_OF_ROW (r->range.end.row);
-	DependencyRange r2 = *r;
+	DependencyRange *result;
 
 	if (!deps)
 		return;
 
-	for ( ; i <= end; i++) {
-		DependencyRange *result;
-
-		/* Restrict range to bucket.  */
-		r2.range.start.row = MAX (r->range.start.row, BUCKET_START_ROW (i));
-		r2.range.end.row = MIN (r->range.end.row, BUCKET_END_ROW (i));
-
-		result = g_hash_table_lookup (deps->range_hash[i], &r2);
-		if (result) {
-			micro_hash_remove (&result->deps, dep);
-			if (micro_hash_is_empty (&result->deps)) {
-				g_hash_table_remove (deps->range_hash[i], result);
-				micro_hash_release (&result->deps);
-				go_mem_chunk_free (deps->range_pool, result);
-			}
+	result = g_hash_table_lookup (deps->range_hash, r);
+	if (result) {
+		micro_hash_remove (&result->deps, dep);
+		if (micro_hash_is_empty (&result->deps)) {
+			g_hash_table_remove (deps->range_hash, result);
+			deprange_unindex (deps, result);
+			micro_hash_release (&result->deps);
+			go_mem_chunk_free (deps->range_pool, result);
 		}
 	}
 }
@@ -1059,11 +1341,13 @@ link_expr_dep (GnmEvalPos *ep, GnmExpr const *tree)
 		DependentFlags flag = DEPENDENT_NO_FLAG;
 		if (tree->func.func->fn_type == GNM_FUNC_TYPE_STUB)
 			gnm_func_load_stub (tree->func.func);
+		if (tree->func.func->flags & GNM_FUNC_VOLATILE)
+			flag |= DEPENDENT_HAS_VOLATILE;
 		if (tree->func.func->linker) {
 			GnmFuncEvalInfo fei;
 			fei.pos = ep;
 			fei.func_call = &tree->func;
-			flag = tree->func.func->linker (&fei);
+			flag |= tree->func.func->linker (&fei);
 		}
 		if (!(flag & DEPENDENT_IGNORE_ARGS))
 			for (i = 0; i < tree->func.argc; i++)
@@ -1295,6 +1579,67 @@ dynamic_dep_debug_name (GnmDependent const *dep, GString *target)
 	g_string_append_printf (target, "DynamicDep%p", (void *)dep);
 }
 
+/*
+ * Returns TRUE if @rr is already linked.  If the previous evaluation
+ * linked it, it is stamped with the current one and added to @cur.  The
+ * links are sets so @cur must not hold duplicates, or unlinking one copy
+ * would drop the other.
+ */
+static gboolean
+dynamic_dep_reuse (DynamicDep *dyn, GSList **cur, GnmRangeRef const *rr)
+{
+	gpointer key, generation;
+
+	if (!g_hash_table_lookup_extended (dyn->requested, rr,
+					   &key, &generation))
+		return FALSE;
+
+	if (GPOINTER_TO_UINT (generation) != dyn->generation) {
+		g_hash_table_insert (dyn->requested, key,
+				     GUINT_TO_POINTER (dyn->generation));
+		*cur = g_slist_prepend (*cur, key);
+	}
+	return TRUE;
+}
+
+/* Has @rr been asked for again since dependent_begin_dynamic_deps ?  */
+static gboolean
+dynamic_dep_is_current (DynamicDep const *dyn, GnmRangeRef const *rr)
+{
+	return GPOINTER_TO_UINT (g_hash_table_lookup (dyn->requested, rr)) ==
+		dyn->generation;
+}
+
+static void
+dynamic_dep_unlink_old (DynamicDep *dyn)
+{
+	GnmCellPos const *pos = dependent_pos (dyn->container);
+	GnmRangeRef *rr;
+	GSList *ptr;
+
+	for (ptr = dyn->old_singles ; ptr != NULL ; ptr = ptr->next) {
+		rr = ptr->data;
+		if (dynamic_dep_is_current (dyn, rr))
+			continue;
+		unlink_single_dep (&dyn->base, pos, &rr->a);
+		g_hash_table_remove (dyn->requested, rr);
+		g_free (rr);
+	}
+	g_slist_free (dyn->old_singles);
+	dyn->old_singles = NULL;
+
+	for (ptr = dyn->old_ranges ; ptr != NULL ; ptr = ptr->next) {
+		rr = ptr->data;
+		if (dynamic_dep_is_current (dyn, rr))
+			continue;
+		unlink_cellrange_dep (&dyn->base, pos, &rr->a, &rr->b);
+		g_hash_table_remove (dyn->requested, rr);
+		g_free (rr);
+	}
+	g_slist_free (dyn->old_ranges);
+	dyn->old_ranges = NULL;
+}
+
 void
 dependent_add_dynamic_dep (GnmDependent *dep, GnmRangeRef const *rr)
 {
@@ -1302,6 +1647,7 @@ dependent_add_dynamic_dep (GnmDependent *dep, GnmRangeRef const *rr)
 	DynamicDep	 *dyn;
 	GnmCellPos const *pos;
 	DependencyRange   range;
+	GnmRangeRef	 *copy;
 
 	g_return_if_fail (dep != NULL);
 
@@ -1318,18 +1664,32 @@ dependent_add_dynamic_dep (GnmDependent *dep, GnmRangeRef const *rr)
 		dyn->container		= dep;
 		dyn->ranges		= NULL;
 		dyn->singles		= NULL;
+		dyn->old_ranges		= NULL;
+		dyn->old_singles	= NULL;
+		dyn->requested		= g_hash_table_new (
+			(GHashFunc)gnm_rangeref_hash,
+			(GEqualFunc)gnm_rangeref_equal);
+		dyn->generation		= 0;
 		g_hash_table_insert (dep->sheet->deps->dynamic_deps, dep, dyn);
 	}
 
 	gnm_cellpos_init_cellref (&range.range.start, &rr->a, pos, dep->sheet);
 	gnm_cellpos_init_cellref (&range.range.end, &rr->b, pos, dep->sheet);
 	if (range_is_singleton (&range.range)) {
+		if (dynamic_dep_reuse (dyn, &dyn->singles, rr))
+			return;
 		flags = link_single_dep (&dyn->base, pos, &rr->a);
-		dyn->singles = g_slist_prepend (dyn->singles, gnm_rangeref_dup (rr));
+		copy = gnm_rangeref_dup (rr);
+		dyn->singles = g_slist_prepend (dyn->singles, copy);
 	} else {
+		if (dynamic_dep_reuse (dyn, &dyn->ranges, rr))
+			return;
 		flags = link_cellrange_dep (&dyn->base, pos, &rr->a, &rr->b);
-		dyn->ranges = g_slist_prepend (dyn->ranges, gnm_rangeref_dup (rr));
+		copy = gnm_rangeref_dup (rr);
+		dyn->ranges = g_slist_prepend (dyn->ranges, copy);
 	}
+	g_hash_table_insert (dyn->requested, copy,
+			     GUINT_TO_POINTER (dyn->generation));
 	if (flags & DEPENDENT_HAS_3D)
 		workbook_link_3d_dep (dep);
 }
@@ -1340,8 +1700,83 @@ dependent_clear_dynamic_deps (GnmDependent *dep)
 	g_hash_table_remove (dep->sheet->deps->dynamic_deps, dep);
 }
 
+/*
+ * Evaluating a dependent usually asks for the same dynamic ranges as the
+ * last time.  Rather than unlinking them all up front and linking them
+ * again, set them aside in dependent_begin_dynamic_deps, take back the
+ * ones that are asked for again in dependent_add_dynamic_dep and only
+ * unlink what is left over in dependent_end_dynamic_deps.
+ */
+static void
+dependent_begin_dynamic_deps (GnmDependent *dep)
+{
+	DynamicDep *dyn;
+
+	if (!(dep->flags & DEPENDENT_HAS_DYNAMIC_DEPS))
+		return;
+
+	dyn = g_hash_table_lookup (dep->sheet->deps->dynamic_deps, dep);
+	g_return_if_fail (dyn != NULL);
+
+	dyn->old_ranges = g_slist_concat (dyn->ranges, dyn->old_ranges);
+	dyn->ranges = NULL;
+	dyn->old_singles = g_slist_concat (dyn->singles, dyn->old_singles);
+	dyn->singles = NULL;
+	dyn->generation++;
+}
+
+static void
+dependent_end_dynamic_deps (GnmDependent *dep)
+{
+	DynamicDep *dyn;
+
+	if (!(dep->flags & DEPENDENT_HAS_DYNAMIC_DEPS))
+		return;
+
+	dyn = g_hash_table_lookup (dep->sheet->deps->dynamic_deps, dep);
+	g_return_if_fail (dyn != NULL);
+
+	if (dyn->ranges == NULL && dyn->singles == NULL) {
+		dependent_clear_dynamic_deps (dep);
+		dep->flags &= ~DEPENDENT_HAS_DYNAMIC_DEPS;
+	} else
+		dynamic_dep_unlink_old (dyn);
+}
+
 /*****************************************************************************/
 
+/*
+ * Squeeze the NULLs left by unlinked dependents out of linked_order,
+ * keeping the order of the rest.  Nothing is moved during a safe walk.
+ */
+static void
+linked_order_compact (GnmDepContainer *deps)
+{
+	GPtrArray *order = deps->linked_order;
+	guint i, j;
+
+	if (deps->safe_walks > 0 || deps->n_unlinked == 0)
+		return;
+
+	for (i = j = 0; i < order->len; i++) {
+		GnmDependent *dep = g_ptr_array_index (order, i);
+		if (dep == NULL)
+			continue;
+		g_ptr_array_index (order, j) = dep;
+		dep->link_index = j++;
+	}
+	g_ptr_array_set_size (order, j);
+	deps->n_unlinked = 0;
+}
+
+static inline void
+linked_order_maybe_compact (GnmDepContainer *deps)
+{
+	if (deps->n_unlinked > 64 &&
+	    deps->n_unlinked > deps->linked_order->len / 2)
+		linked_order_compact (deps);
+}
+
 /**
  * dependent_link:
  * @dep : the dependent that changed
@@ -1362,19 +1797,22 @@ dependent_link (GnmDependent *dep)
 
 	sheet = dep->sheet;
 
-	/* Make this the new tail of the dependent list.  */
-	dep->prev_dep = sheet->deps->tail;
-	dep->next_dep = NULL;
-	if (dep->prev_dep)
-		dep->prev_dep->next_dep = dep;
-	else
-		sheet->deps->head = dep; /* first element */
-	sheet->deps->tail = dep;
+	dep->link_index = sheet->deps->linked_order->len;
+	g_ptr_array_add (sheet->deps->linked_order, dep);
 	dep->flags |= DEPENDENT_IS_LINKED |
 		link_expr_dep (eval_pos_init_dep (&ep, dep), dep->texpr->expr);
 
 	if (dep->flags & DEPENDENT_HAS_3D)
 		workbook_link_3d_dep (dep);
+
+	if (dependent_needs_recalc (dep)) {
+		g_hash_table_insert (sheet->deps->dirty, dep, dep);
+		if (dependent_is_cell (dep))
+			dep_container_note_dirty (sheet->deps,
+						  &GNM_DEP_TO_CELL (dep)->pos);
+	}
+	if (dep->flags & DEPENDENT_HAS_VOLATILE)
+		g_hash_table_insert (sheet->deps->volatile_deps, dep, dep);
 }
 
 /**
@@ -1397,17 +1835,19 @@ dependent_unlink (GnmDependent *dep)
 	unlink_expr_dep (dep, dep->texpr->expr);
 	contain = dep->sheet->deps;
 	if (contain != NULL) {
-		if (contain->head == dep)
-			contain->head = dep->next_dep;
-		if (contain->tail == dep)
-			contain->tail = dep->prev_dep;
-		if (dep->next_dep)
-			dep->next_dep->prev_dep = dep->prev_dep;
-		if (dep->prev_dep)
-			dep->prev_dep->next_dep = dep->next_dep;
+		GPtrArray *order = contain->linked_order;
+		if (dep->link_index < order->len &&
+		    g_ptr_array_index (order, dep->link_index) == dep) {
+			g_ptr_array_index (order, dep->link_index) = NULL;
+			contain->n_unlinked++;
+			linked_order_maybe_compact (contain);
+		}
 
 		if (dep->flags & DEPENDENT_HAS_DYNAMIC_DEPS)
 			dependent_clear_dynamic_deps (dep);
+		g_hash_table_remove (contain->dirty, dep);
+		if (dep->flags & DEPENDENT_HAS_VOLATILE)
+			g_hash_table_remove (contain->volatile_deps, dep);
 	}
 
 	if (dep->flags & DEPENDENT_HAS_3D)
@@ -1415,41 +1855,646 @@ dependent_unlink (GnmDependent *dep)
 	dep->flags &= ~DEPENDENT_LINK_FLAGS;
 }
 
-/**
- * gnm_cell_eval_content:
- * @cell: the cell to evaluate.
- *
- * This function evaluates the contents of the cell,
- * it should not be used by anyone. It is an internal
- * function.
- **/
-gboolean
-gnm_cell_eval_content (GnmCell *cell)
+static void
+cb_dep_input_changed (GnmDependent *dep, G_GNUC_UNUSED gpointer user)
 {
-	static GnmCell *iterating = NULL;
-	GnmValue   *v;
-	GnmEvalPos	 pos;
-	int	 max_iteration;
+	dep->flags &= ~DEPENDENT_CHECK_INPUTS;
+}
 
-	if (!gnm_cell_has_expr (cell) ||	/* plain cells without expr */
-	    !dependent_is_linked (&cell->base)) /* special case within TABLE */
-		return TRUE;
+/* @cell has a new value, anything waiting to see that needs a recalc.  */
+static void
+cell_notify_changed (GnmCell const *cell)
+{
+	cell_foreach_dep (cell, cb_dep_input_changed, NULL);
+}
 
-	/* do this here rather than dependent_eval
-	 * because this routine is sometimes called
-	 * directly
-	 */
-	if (cell->base.flags & DEPENDENT_HAS_DYNAMIC_DEPS) {
-		dependent_clear_dynamic_deps (GNM_CELL_TO_DEP (cell));
-		cell->base.flags &= ~DEPENDENT_HAS_DYNAMIC_DEPS;
+/*
+ * While an incremental recalc slice runs this maps each sheet to the
+ * bounding box of the cells whose value changed, so that they can be
+ * repainted as soon as the slice ends.
+ */
+static GHashTable *recalc_changed = NULL;
+
+static void
+recalc_note_changed (GnmCell const *cell)
+{
+	GnmRange *r = g_hash_table_lookup (recalc_changed, cell->base.sheet);
+
+	if (r == NULL) {
+		r = g_new (GnmRange, 1);
+		range_init_cellpos (r, &cell->pos);
+		g_hash_table_insert (recalc_changed, cell->base.sheet, r);
+	} else {
+		if (cell->pos.col < r->start.col) r->start.col = cell->pos.col;
+		if (cell->pos.col > r->end.col)   r->end.col   = cell->pos.col;
+		if (cell->pos.row < r->start.row) r->start.row = cell->pos.row;
+		if (cell->pos.row > r->end.row)   r->end.row   = cell->pos.row;
 	}
+}
 
-#ifdef DEBUG_EVALUATION
-	{
-		GnmParsePos pp;
-		char *str = gnm_expr_top_as_string
-			(cell->base.texpr,
-			 parse_pos_init_cell (&pp, cell),
+/*
+ * cell_assign_computed_value:
+ * @cell: the cell whose expression was just evaluated.
+ * @v: the result, ownership is taken.
+ *
+ * Store a freshly computed value in @cell, skipping the unrender when
+ * nothing changed.
+ */
+static void
+cell_assign_computed_value (GnmCell *cell, GnmValue *v)
+{
+	gboolean had_value = (cell->value != NULL);
+	if (had_value && value_equal (v, cell->value)) {
+		/* Value didn't change.  */
+		value_release (v);
+	} else {
+		gboolean was_string = had_value && (VALUE_IS_STRING (cell->value) || VALUE_IS_ERROR (cell->value));
+		gboolean is_string = VALUE_IS_STRING (v) || VALUE_IS_ERROR (v);
+
+		if ((was_string || is_string) && cell->row_info)
+			cell->row_info->needs_respan = TRUE;
+
+		if (had_value)
+			value_release (cell->value);
+		cell->value = v;
+
+		gnm_cell_unrender (cell);
+		cell_notify_changed (cell);
+		if (recalc_changed != NULL)
+			recalc_note_changed (cell);
+	}
+}
+
+/*
+ * Like cell_assign_computed_value for a number or boolean.  A new number
+ * overwrites the plain number the cell already holds rather than
+ * replacing it, so recalculating numeric cells does not allocate.
+ */
+static void
+cell_assign_computed_number (GnmCell *cell, gnm_float f, gboolean is_bool)
+{
+	GnmValue *old = cell->value;
+
+	if (is_bool || old == NULL || !VALUE_IS_FLOAT (old) ||
+	    (old->v_float.val != f && VALUE_FMT (old) != NULL)) {
+		cell_assign_computed_value (cell, is_bool
+			? value_new_bool (f != 0)
+			: value_new_float (f));
+		return;
+	}
+
+	if (old->v_float.val == f)
+		return;		/* Value didn't change.  */
+
+	old->v_float.val = f;
+	gnm_cell_unrender (cell);
+	cell_notify_changed (cell);
+	if (recalc_changed != NULL)
+		recalc_note_changed (cell);
+}
+
+/*****************************************************************************
+ * Evaluation scheduling
+ *
+ * Before a cell is evaluated its dirty precedents are evaluated in
+ * post-order using an explicit stack.  Without this a long chain of dirty
+ * cells, such as a running balance filled down a column, is evaluated by
+ * gnm_cell_eval recursing once per link of the chain.
+ *
+ * The walk is Tarjan's algorithm, so the dirty precedents come out grouped
+ * into strongly connected components in dependency order.  A component of
+ * one cell that does not refer to itself is simply evaluated.  Anything
+ * else is a circular reference and is iterated as a unit, Gauss-Seidel
+ * style, until no member changes by more than the workbook's tolerance or
+ * the iteration limit is reached.
+ *
+ * Cycles through dependencies the walk cannot see, such as those created
+ * by INDIRECT, still end up in gnm_cell_eval_content's recursive
+ * iteration.
+ */
+
+typedef enum {
+	SCHED_NEW = 0,
+	SCHED_SEEN,	/* On the stack, not yet expanded */
+	SCHED_ACTIVE,	/* On the current path */
+	SCHED_ONSTACK,	/* Expanded, component not yet complete */
+	SCHED_DONE
+} SchedState;
+
+typedef struct {
+	SchedState state;
+	guint	   index, low;
+	gboolean   self_ref;
+} SchedNode;
+
+typedef struct {
+	GnmCell    *root;	 /* NULL when scanning */
+	SchedNode   root_node;
+	GPtrArray  *stack;
+	GPtrArray  *path;
+	GPtrArray  *scc;	 /* Tarjan's stack of unfinished cells */
+	GHashTable *nodes;
+	guint	    counter;
+	gboolean    scan;	 /* find cycles among all cells, evaluate nothing */
+	gboolean    cyclic;	 /* some component was a cycle */
+	gboolean    incomplete;	 /* some dirty precedents were not queued */
+	GSList	   *cycles;	 /* when scanning, the cycles found */
+} EvalSchedule;
+
+/* Names referring to names referring to ... give up at some point.  */
+#define SCHED_MAX_NAME_DEPTH 32
+
+static gboolean cell_eval_scheduling = FALSE;
+/* The precedents of the cell the scheduler is about to evaluate are all
+ * up to date.  */
+static gboolean cell_eval_settled = FALSE;
+
+static SchedNode *
+sched_get_node (EvalSchedule *sched, GnmCell const *cell)
+{
+	if (cell == sched->root)
+		return &sched->root_node;
+	return sched->nodes
+		? g_hash_table_lookup (sched->nodes, cell)
+		: NULL;
+}
+
+/* The cell whose precedents are being queued.  */
+static SchedNode *
+sched_parent (EvalSchedule *sched)
+{
+	if (sched->path == NULL || sched->path->len == 0)
+		return &sched->root_node;
+	return sched_get_node (sched,
+		g_ptr_array_index (sched->path, sched->path->len - 1));
+}
+
+static void
+sched_push (EvalSchedule *sched, GnmCell *cell)
+{
+	SchedNode *node, *parent;
+
+	if (cell == NULL ||
+	    !gnm_cell_has_expr (cell) ||
+	    !dependent_is_linked (GNM_CELL_TO_DEP (cell)))
+		return;
+
+	if (!sched->scan) {
+		if (!gnm_cell_needs_recalc (cell))
+			return;
+		if (cell->base.flags & DEPENDENT_BEING_CALCULATED) {
+			sched->incomplete = TRUE;
+			return;
+		}
+	}
+
+	node = sched_get_node (sched, cell);
+	switch (node ? node->state : SCHED_NEW) {
+	case SCHED_NEW:
+		if (sched->nodes == NULL) {
+			sched->nodes = g_hash_table_new_full
+				(g_direct_hash, g_direct_equal, NULL, g_free);
+			sched->stack = g_ptr_array_new ();
+		}
+		node = g_new0 (SchedNode, 1);
+		node->state = SCHED_SEEN;
+		g_hash_table_insert (sched->nodes, cell, node);
+		/* Fall through.  */
+	case SCHED_SEEN:
+		g_ptr_array_add (sched->stack, cell);
+		break;
+
+	case SCHED_ACTIVE:
+	case SCHED_ONSTACK:
+		parent = sched_parent (sched);
+		if (node == parent)
+			parent->self_ref = TRUE;
+		parent->low = MIN (parent->low, node->index);
+		break;
+
+	case SCHED_DONE:
+		break;
+	}
+}
+
+static GnmValue *
+cb_sched_push_cell (GnmCellIter const *iter, EvalSchedule *sched)
+{
+	sched_push (sched, iter->cell);
+	return NULL;
+}
+
+static void
+sched_push_range (EvalSchedule *sched, GnmDependent const *dep,
+		  GnmCellRef const *a, GnmCellRef const *b)
+{
+	GnmCellPos const *pos = dependent_pos (dep);
+	GnmRange r;
+	int i, stop;
+
+	gnm_cellpos_init_cellref (&r.start, a, pos, dep->sheet);
+	gnm_cellpos_init_cellref (&r.end, b, pos, dep->sheet);
+	range_normalize (&r);
+
+	if (a->sheet != NULL && b->sheet != NULL && a->sheet != b->sheet) {
+		Workbook const *wb = a->sheet->workbook;
+
+		g_return_if_fail (b->sheet->workbook == wb);
+
+		i = a->sheet->index_in_wb;
+		stop = b->sheet->index_in_wb;
+		if (i > stop) { int tmp = i; i = stop ; stop = tmp; }
+	} else
+		i = stop = -1;
+
+	do {
+		Sheet *sheet = (i < 0)
+			? eval_sheet (a->sheet, dep->sheet)
+			: g_ptr_array_index (a->sheet->workbook->sheets, i);
+		/* Usually nothing in the range is dirty, don't look.  */
+		if (sched->scan ||
+		    (sheet->deps != NULL &&
+		     dep_container_may_be_dirty (sheet->deps, &r)))
+			sheet_foreach_cell_in_range (sheet, CELL_ITER_IGNORE_NONEXISTENT,
+				r.start.col, r.start.row, r.end.col, r.end.row,
+				(CellIterFunc) &cb_sched_push_cell, sched);
+	} while (++i <= stop);
+}
+
+/* Queue the dirty cells @expr, evaluated for @dep, can refer to.  */
+static void
+sched_push_expr (EvalSchedule *sched, GnmDependent const *dep,
+		 GnmExpr const *expr, int name_depth)
+{
+	int i;
+
+	switch (GNM_EXPR_GET_OPER (expr)) {
+	case GNM_EXPR_OP_RANGE_CTOR:
+	case GNM_EXPR_OP_INTERSECT:
+	case GNM_EXPR_OP_ANY_BINARY:
+		sched_push_expr (sched, dep, expr->binary.value_a, name_depth);
+		sched_push_expr (sched, dep, expr->binary.value_b, name_depth);
+		break;
+
+	case GNM_EXPR_OP_ANY_UNARY:
+		sched_push_expr (sched, dep, expr->unary.value, name_depth);
+		break;
+
+	case GNM_EXPR_OP_CELLREF: {
+		GnmCellRef const *ref = &expr->cellref.ref;
+		Sheet *sheet = eval_sheet (ref->sheet, dep->sheet);
+		GnmCellPos pos;
+
+		gnm_cellpos_init_cellref (&pos, ref, dependent_pos (dep), sheet);
+		sched_push (sched, sheet_cell_get (sheet, pos.col, pos.row));
+		break;
+	}
+
+	case GNM_EXPR_OP_CONSTANT:
+		if (VALUE_CELLRANGE == expr->constant.value->type)
+			sched_push_range (sched, dep,
+				&expr->constant.value->v_range.cell.a,
+				&expr->constant.value->v_range.cell.b);
+		break;
+
+	case GNM_EXPR_OP_FUNCALL:
+		for (i = 0; i < expr->func.argc; i++)
+			sched_push_expr (sched, dep, expr->func.argv[i],
+					 name_depth);
+		break;
+
+	case GNM_EXPR_OP_NAME:
+		if (!expr_name_is_active (expr->name.name))
+			break;
+		if (name_depth < SCHED_MAX_NAME_DEPTH)
+			sched_push_expr (sched, dep,
+					 expr->name.name->texpr->expr,
+					 name_depth + 1);
+		else
+			sched->incomplete = TRUE;
+		break;
+
+	case GNM_EXPR_OP_ARRAY_ELEM: {
+		GnmCellPos const *pos = dependent_pos (dep);
+		sched_push (sched, sheet_cell_get (dep->sheet,
+			pos->col - expr->array_elem.x,
+			pos->row - expr->array_elem.y));
+		break;
+	}
+
+	case GNM_EXPR_OP_ARRAY_CORNER:
+		sched_push_expr (sched, dep, expr->array_corner.expr,
+				 name_depth);
+		break;
+
+	case GNM_EXPR_OP_SET:
+		for (i = 0; i < expr->set.argc; i++)
+			sched_push_expr (sched, dep, expr->set.argv[i],
+					 name_depth);
+		break;
+
+#ifndef DEBUG_SWITCH_ENUM
+	default:
+		g_assert_not_reached ();
+#endif
+	}
+}
+
+/*
+ * Evaluate the members of a circular reference, in the order given, until
+ * they converge.  With iteration disabled they are evaluated just once.
+ */
+static void
+cell_iterate_cycle (GPtrArray *members)
+{
+	Workbook const *wb =
+		((GnmCell *)g_ptr_array_index (members, 0))->base.sheet->workbook;
+	int max_iteration = wb->iteration.enabled
+		? MAX (wb->iteration.max_number, 1) : 1;
+	guint i;
+
+	for (i = 0; i < members->len; i++) {
+		GnmCell *cell = g_ptr_array_index (members, i);
+		/* References between members read the current value.  */
+		cell->base.flags &= ~(DEPENDENT_NEEDS_RECALC |
+				      DEPENDENT_CHECK_INPUTS);
+		cell->base.flags |= DEPENDENT_BEING_CALCULATED;
+	}
+
+	while (max_iteration-- > 0) {
+		gnm_float diff = 0.;
+
+		/* The members change under the recalc caches each round */
+		gnm_app_recalc_clear_caches ();
+
+		for (i = 0; i < members->len; i++) {
+			GnmCell *cell = g_ptr_array_index (members, i);
+			GnmEvalPos pos;
+			GnmValue *v;
+			gnm_float d, num;
+			gboolean is_bool, unboxed;
+
+			if (gnm_recalc_profiling)
+				gnm_recalc_profile_enter ();
+			dependent_begin_dynamic_deps (GNM_CELL_TO_DEP (cell));
+			v = gnm_expr_top_eval_unboxed (cell->base.texpr,
+						       eval_pos_init_cell (&pos, cell),
+						       GNM_EXPR_EVAL_SCALAR_NON_EMPTY,
+						       &num, &is_bool, &unboxed);
+			dependent_end_dynamic_deps (GNM_CELL_TO_DEP (cell));
+			if (unboxed)
+				v = is_bool
+					? value_new_bool (num != 0)
+					: value_new_float (num);
+			else if (v == NULL)
+				v = value_new_error (&pos, "Internal error");
+			if (gnm_recalc_profiling)
+				gnm_recalc_profile_leave_dep (GNM_CELL_TO_DEP (cell));
+
+			d = value_diff (cell->value, v);
+			if (d > diff)
+				diff = d;
+			cell_assign_computed_value (cell, v);
+		}
+
+		if (diff < wb->iteration.tolerance)
+			break;
+	}
+
+	for (i = 0; i < members->len; i++) {
+		GnmCell *cell = g_ptr_array_index (members, i);
+		cell->base.flags &= ~DEPENDENT_BEING_CALCULATED;
+	}
+}
+
+/* @top has been expanded and all its precedents are done.  */
+static void
+sched_finish (EvalSchedule *sched, GnmCell *top)
+{
+	SchedNode *node = sched_get_node (sched, top);
+	GPtrArray *members;
+	GnmCell *member;
+
+	if (node->low != node->index) {
+		node->state = SCHED_ONSTACK;
+		return;
+	}
+
+	/* @top is the first cell of its component, pop the lot.  */
+	members = g_ptr_array_new ();
+	do {
+		member = g_ptr_array_index (sched->scc, sched->scc->len - 1);
+		g_ptr_array_set_size (sched->scc, sched->scc->len - 1);
+		sched_get_node (sched, member)->state = SCHED_DONE;
+		g_ptr_array_add (members, member);
+	} while (member != top);
+
+	if (members->len == 1 && !node->self_ref) {
+		g_ptr_array_free (members, TRUE);
+		if (!sched->scan) {
+			cell_eval_settled = (!sched->cyclic && !sched->incomplete);
+			gnm_cell_eval (top);
+			cell_eval_settled = FALSE;
+		}
+		return;
+	}
+
+	sched->cyclic = TRUE;
+	if (sched->scan)
+		sched->cycles = g_slist_prepend (sched->cycles, members);
+	else {
+		cell_iterate_cycle (members);
+		g_ptr_array_free (members, TRUE);
+	}
+}
+
+static void
+sched_run (EvalSchedule *sched)
+{
+	while (sched->stack->len > 0) {
+		GnmCell *top = g_ptr_array_index (sched->stack,
+						  sched->stack->len - 1);
+		SchedNode *node = sched_get_node (sched, top), *parent;
+
+		switch (node->state) {
+		case SCHED_SEEN:
+			if (!sched->scan && !gnm_cell_needs_recalc (top)) {
+				node->state = SCHED_DONE;
+				break;
+			}
+			node->state = SCHED_ACTIVE;
+			node->index = node->low = sched->counter++;
+			g_ptr_array_add (sched->path, top);
+			g_ptr_array_add (sched->scc, top);
+			sched_push_expr (sched, GNM_CELL_TO_DEP (top),
+					 top->base.texpr->expr, 0);
+			continue;
+
+		case SCHED_ACTIVE:
+			/* All precedents are done.  */
+			g_ptr_array_set_size (sched->path, sched->path->len - 1);
+			sched_finish (sched, top);
+			if (sched->path->len > 0) {
+				parent = sched_parent (sched);
+				parent->low = MIN (parent->low, node->low);
+			}
+			break;
+
+		case SCHED_ONSTACK:
+			/* Queued by the current path top before it was
+			 * reached through another precedent.  */
+			parent = sched_parent (sched);
+			parent->low = MIN (parent->low, node->index);
+			break;
+
+		default:
+			/* Duplicate entry that has already been handled.  */
+			break;
+		}
+		g_ptr_array_set_size (sched->stack, sched->stack->len - 1);
+	}
+}
+
+static void
+sched_init (EvalSchedule *sched, GnmCell *root, gboolean scan)
+{
+	memset (sched, 0, sizeof (*sched));
+	sched->root = root;
+	sched->scan = scan;
+	sched->root_node.state = SCHED_ACTIVE;
+}
+
+static void
+sched_clear (EvalSchedule *sched)
+{
+	if (sched->path)
+		g_ptr_array_free (sched->path, TRUE);
+	if (sched->scc)
+		g_ptr_array_free (sched->scc, TRUE);
+	if (sched->stack)
+		g_ptr_array_free (sched->stack, TRUE);
+	if (sched->nodes)
+		g_hash_table_destroy (sched->nodes);
+}
+
+/*
+ * Evaluate the dirty precedents of @cell, but not @cell itself, without
+ * recursing.  Returns TRUE if none of them is left dirty.  If @cell turns
+ * out to be part of a circular reference, the whole cycle, @cell
+ * included, is evaluated and @solved is set.
+ */
+static gboolean
+cell_eval_precedents (GnmCell *cell, gboolean *solved)
+{
+	EvalSchedule sched;
+	gboolean settled;
+
+	*solved = FALSE;
+	sched_init (&sched, cell, FALSE);
+
+	sched_push_expr (&sched, GNM_CELL_TO_DEP (cell),
+			 cell->base.texpr->expr, 0);
+	if (sched.nodes == NULL && !sched.root_node.self_ref)
+		return !sched.incomplete; /* Nothing dirty, the common case.  */
+
+	/* The root is implicitly the bottom of the path.  */
+	sched.counter = 1;
+	sched.path = g_ptr_array_new ();
+	sched.scc = g_ptr_array_new ();
+	g_ptr_array_add (sched.path, cell);
+	g_ptr_array_add (sched.scc, cell);
+	cell_eval_scheduling = TRUE;
+
+	if (sched.stack != NULL)
+		sched_run (&sched);
+
+	/* Whatever is left on Tarjan's stack is in a cycle with @cell.  */
+	if (sched.scc->len > 1 || sched.root_node.self_ref) {
+		sched.cyclic = TRUE;
+		cell_iterate_cycle (sched.scc);
+		*solved = TRUE;
+	}
+
+	cell_eval_scheduling = FALSE;
+	settled = (!sched.cyclic && !sched.incomplete);
+	sched_clear (&sched);
+
+	return settled;
+}
+
+/**
+ * workbook_find_cycles :
+ * @wb :
+ *
+ * Finds the circular references between the cells of @wb.  Dependencies
+ * that are only known once evaluated, such as those of INDIRECT, are not
+ * seen.
+ *
+ * Returns a list of GPtrArrays of the GnmCells in each cycle.  The caller
+ * owns the list and the arrays.
+ **/
+GSList *
+workbook_find_cycles (Workbook *wb)
+{
+	EvalSchedule sched;
+	GSList *res;
+
+	g_return_val_if_fail (IS_WORKBOOK (wb), NULL);
+
+	sched_init (&sched, NULL, TRUE);
+	sched.path = g_ptr_array_new ();
+	sched.scc = g_ptr_array_new ();
+
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		SHEET_FOREACH_DEPENDENT (sheet, dep, {
+			if (dependent_is_cell (dep)) {
+				sched_push (&sched, GNM_DEP_TO_CELL (dep));
+				if (sched.stack != NULL)
+					sched_run (&sched);
+			}
+		});
+	});
+
+	res = g_slist_reverse (sched.cycles);
+	sched_clear (&sched);
+	return res;
+}
+
+static gboolean
+cell_eval_content (GnmCell *cell)
+{
+	static GnmCell *iterating = NULL;
+	GnmValue   *v;
+	GnmEvalPos	 pos;
+	int	 max_iteration;
+	gboolean settled, check_inputs;
+	gnm_float num;
+	gboolean is_bool, unboxed;
+
+	/* Only the scheduler's own call may rely on its verdict.  */
+	settled = cell_eval_settled;
+	cell_eval_settled = FALSE;
+
+	if (!gnm_cell_has_expr (cell) ||	/* plain cells without expr */
+	    !dependent_is_linked (&cell->base)) /* special case within TABLE */
+		return TRUE;
+
+	/* Can we skip this if no precedent changes ?  */
+	check_inputs = (cell->base.flags & DEPENDENT_CHECK_INPUTS) &&
+		gnm_cell_needs_recalc (cell) &&
+		cell->value != NULL &&
+		!(cell->base.flags & (DEPENDENT_HAS_DYNAMIC_DEPS |
+				      DEPENDENT_HAS_VOLATILE |
+				      DEPENDENT_IGNORE_ARGS |
+				      GNM_CELL_HAS_NEW_EXPR)) &&
+		GNM_EXPR_GET_OPER (cell->base.texpr->expr) != GNM_EXPR_OP_ARRAY_ELEM;
+
+#ifdef DEBUG_EVALUATION
+	{
+		GnmParsePos pp;
+		char *str = gnm_expr_top_as_string
+			(cell->base.texpr,
+			 parse_pos_init_cell (&pp, cell),
 			 NULL);
 		g_printerr ("{\nEvaluating %s!%s: %s;\n",
 			    cell->base.sheet->name_quoted, cell_name (cell),
@@ -1458,7 +2503,8 @@ gnm_cell_eval_content (GnmCell *cell)
 	}
 #endif
 
-	/* This is the bottom of a cycle */
+	/* This is the bottom of a cycle the scheduler could not see, see
+	 * cell_iterate_cycle for the ones it does.  */
 	if (cell->base.flags & DEPENDENT_BEING_CALCULATED) {
 		if (!cell->base.sheet->workbook->iteration.enabled)
 			return TRUE;
@@ -1494,15 +2540,49 @@ gnm_cell_eval_content (GnmCell *cell)
 		}
 	}
 
+	if (!cell_eval_scheduling) {
+		gboolean solved;
+		settled = cell_eval_precedents (cell, &solved);
+		if (solved)
+			return TRUE;
+	}
+
+	/* Evaluating the precedents did not change any of them.  */
+	if (check_inputs && settled &&
+	    (cell->base.flags & DEPENDENT_CHECK_INPUTS)) {
+		cell->base.flags &= ~DEPENDENT_CHECK_INPUTS;
+		return TRUE;
+	}
+	cell->base.flags &= ~DEPENDENT_CHECK_INPUTS;
+
 	/* Prepare to calculate */
 	eval_pos_init_cell (&pos, cell);
 	cell->base.flags |= DEPENDENT_BEING_CALCULATED;
 	max_iteration = cell->base.sheet->workbook->iteration.max_number;
 
 iterate :
-	v = gnm_expr_top_eval (cell->base.texpr, &pos,
-			       GNM_EXPR_EVAL_SCALAR_NON_EMPTY);
-	if (v == NULL)
+	/* do this here rather than dependent_eval
+	 * because this routine is sometimes called
+	 * directly
+	 */
+	dependent_begin_dynamic_deps (GNM_CELL_TO_DEP (cell));
+	if (dependent_is_linked (GNM_CELL_TO_DEP (cell)))
+		v = gnm_expr_top_eval_unboxed (cell->base.texpr, &pos,
+					       GNM_EXPR_EVAL_SCALAR_NON_EMPTY,
+					       &num, &is_bool, &unboxed);
+	else {
+		v = gnm_expr_top_eval (cell->base.texpr, &pos,
+				       GNM_EXPR_EVAL_SCALAR_NON_EMPTY);
+		unboxed = FALSE;
+	}
+	dependent_end_dynamic_deps (GNM_CELL_TO_DEP (cell));
+	if (unboxed) {
+		if (!(cell->base.flags & DEPENDENT_BEING_ITERATED)) {
+			cell_assign_computed_number (cell, num, is_bool);
+			goto assigned;
+		}
+		v = is_bool ? value_new_bool (num != 0) : value_new_float (num);
+	} else if (v == NULL)
 		v = value_new_error (&pos, "Internal error");
 
 #ifdef DEBUG_EVALUATION
@@ -1535,6 +2615,10 @@ iterate :
 			cell->value = v;
 
 			gnm_cell_unrender (cell);
+			cell_notify_changed (cell);
+			if (recalc_changed != NULL)
+				recalc_note_changed (cell);
+			gnm_app_recalc_clear_caches ();
 #ifdef DEBUG_EVALUATION
 			puts ("/* LOOP */");
 #endif
@@ -1542,26 +2626,10 @@ iterate :
 		}
 		g_return_val_if_fail (iterating, TRUE);
 		iterating = NULL;
-	} else {
-		gboolean had_value = (cell->value != NULL);
-		if (had_value && value_equal (v, cell->value)) {
-			/* Value didn't change.  */
-			value_release (v);
-		} else {
-			gboolean was_string = had_value && (VALUE_IS_STRING (cell->value) || VALUE_IS_ERROR (cell->value));
-			gboolean is_string = VALUE_IS_STRING (v) || VALUE_IS_ERROR (v);
-
-			if ((was_string || is_string) && cell->row_info)
-				cell->row_info->needs_respan = TRUE;
-
-			if (had_value)
-				value_release (cell->value);
-			cell->value = v;
-
-			gnm_cell_unrender (cell);
-		}
-	}
+	} else
+		cell_assign_computed_value (cell, v);
 
+assigned:
 	if (iterating == cell)
 		iterating = NULL;
 
@@ -1572,6 +2640,28 @@ iterate :
 	return iterating == NULL;
 }
 
+/**
+ * gnm_cell_eval_content:
+ * @cell: the cell to evaluate.
+ *
+ * This function evaluates the contents of the cell,
+ * it should not be used by anyone. It is an internal
+ * function.
+ **/
+gboolean
+gnm_cell_eval_content (GnmCell *cell)
+{
+	gboolean res;
+
+	if (!gnm_recalc_profiling)
+		return cell_eval_content (cell);
+
+	gnm_recalc_profile_enter ();
+	res = cell_eval_content (cell);
+	gnm_recalc_profile_leave_dep (GNM_CELL_TO_DEP (cell));
+	return res;
+}
+
 /**
  * dependent_eval :
  * @dep :
@@ -1586,12 +2676,14 @@ dependent_eval (GnmDependent *dep)
 
 		g_return_if_fail (klass);
 
-		if (dep->flags & DEPENDENT_HAS_DYNAMIC_DEPS) {
-			dependent_clear_dynamic_deps (dep);
-			dep->flags &= ~DEPENDENT_HAS_DYNAMIC_DEPS;
-		}
-
-		klass->eval (dep);
+		dependent_begin_dynamic_deps (dep);
+		if (gnm_recalc_profiling) {
+			gnm_recalc_profile_enter ();
+			klass->eval (dep);
+			gnm_recalc_profile_leave_dep (dep);
+		} else
+			klass->eval (dep);
+		dependent_end_dynamic_deps (dep);
 	} else {
 		/* This will clear the dynamic deps too, see comment there
 		 * to explain asymmetry.
@@ -1605,7 +2697,7 @@ dependent_eval (GnmDependent *dep)
 	}
 
 	/* Don't clear flag until after in case we iterate */
-	dep->flags &= ~DEPENDENT_NEEDS_RECALC;
+	dep->flags &= ~(DEPENDENT_NEEDS_RECALC | DEPENDENT_CHECK_INPUTS);
 }
 
 
@@ -1630,51 +2722,37 @@ cell_queue_recalc (GnmCell *cell)
 		deps = cell_list_deps (cell);
 		dependent_queue_recalc_list (deps);
 		g_slist_free (deps);
-	}
+	} else
+		/* The dependents are queued, but perhaps only to check.  */
+		cell_notify_changed (cell);
 }
 
 typedef struct {
-	int      col, row;
 	DepFunc	 func;
 	gpointer user;
 } search_rangedeps_closure_t;
 
 static void
-cb_search_rangedeps (gpointer key, G_GNUC_UNUSED gpointer value,
-		     gpointer closure)
+cb_search_rangedeps (DependencyRange const *deprange,
+		     G_GNUC_UNUSED GnmRange const *range,
+		     search_rangedeps_closure_t const *c)
 {
-	search_rangedeps_closure_t const *c = closure;
-	DependencyRange const *deprange = key;
-	GnmRange const *range = &(deprange->range);
-
-#if 0
-	/* When things get slow this is a good test to enable */
-	static int counter = 0;
-	if ((++counter % 100000) == 0)
-		g_printerr ("%d\n", counter / 100000);
-#endif
-
-	if (range_contains (range, c->col, c->row)) {
-		DepFunc	 func = c->func;
-		micro_hash_foreach_dep (deprange->deps, dep,
-			(func) (dep, c->user););
-	}
+	DepFunc	 func = c->func;
+	micro_hash_foreach_dep (deprange->deps, dep,
+		(func) (dep, c->user););
 }
 
 static void
 cell_foreach_range_dep (GnmCell const *cell, DepFunc func, gpointer user)
 {
 	search_rangedeps_closure_t closure;
-	GHashTable *bucket =
-		cell->base.sheet->deps->range_hash[BUCKET_OF_ROW (cell->pos.row)];
 
-	if (bucket != NULL) {
-		closure.col = cell->pos.col;
-		closure.row = cell->pos.row;
-		closure.func = func;
-		closure.user = user;
-		g_hash_table_foreach (bucket, &cb_search_rangedeps, &closure);
-	}
+	closure.func = func;
+	closure.user = user;
+	deps_foreach_range_containing (cell->base.sheet->deps,
+				       cell->pos.col, cell->pos.row,
+				       (GnmRTreeFunc) &cb_search_rangedeps,
+				       &closure);
 }
 
 static void
@@ -1714,34 +2792,26 @@ cb_recalc_all_depends (gpointer key, G_GNUC_UNUSED gpointer value,
 	DependencyAny const *depany = key;
 	GSList *work = NULL;
 	micro_hash_foreach_dep (depany->deps, dep, {
-		if (!dependent_needs_recalc (dep)) {
-			dependent_flag_recalc (dep);
+		if (dependent_flag_changed (dep))
 			work = g_slist_prepend (work, dep);
-		}
 	});
 	dependent_queue_recalc_main (work);
 }
 
 
 
+/* Called for the ranges that overlap the target.  */
 static void
-cb_range_contained_depend (gpointer key, G_GNUC_UNUSED gpointer value,
-			   gpointer user)
+cb_range_contained_depend (DependencyRange const *deprange,
+			   G_GNUC_UNUSED GnmRange const *range,
+			   G_GNUC_UNUSED gpointer user)
 {
-	DependencyRange const *deprange  = key;
-	GnmRange const *range = &deprange->range;
-	GnmRange const *target = user;
-
-	if (range_overlap (target, range)) {
-		GSList *work = NULL;
-		micro_hash_foreach_dep (deprange->deps, dep, {
-			if (!dependent_needs_recalc (dep)) {
-				dependent_flag_recalc (dep);
-				work = g_slist_prepend (work, dep);
-			}
-		});
-		dependent_queue_recalc_main (work);
-	}
+	GSList *work = NULL;
+	micro_hash_foreach_dep (deprange->deps, dep, {
+		if (dependent_flag_changed (dep))
+			work = g_slist_prepend (work, dep);
+	});
+	dependent_queue_recalc_main (work);
 }
 
 static void
@@ -1755,10 +2825,8 @@ cb_single_contained_depend (gpointer key,
 	if (range_contains (target, depsingle->pos.col, depsingle->pos.row)) {
 		GSList *work = NULL;
 		micro_hash_foreach_dep (depsingle->deps, dep, {
-			if (!dependent_needs_recalc (dep)) {
-				dependent_flag_recalc (dep);
+			if (dependent_flag_changed (dep))
 				work = g_slist_prepend (work, dep);
-			}
 		});
 		dependent_queue_recalc_main (work);
 	}
@@ -1777,8 +2845,6 @@ cb_single_contained_depend (gpointer key,
 void
 sheet_region_queue_recalc (Sheet const *sheet, GnmRange const *r)
 {
-	int i;
-
 	g_return_if_fail (IS_SHEET (sheet));
 	g_return_if_fail (sheet->deps != NULL);
 
@@ -1788,17 +2854,11 @@ sheet_region_queue_recalc (Sheet const *sheet, GnmRange const *r)
 			dependent_flag_recalc (dep););
 
 		/* look for things that depend on the sheet */
-		for (i = sheet->deps->buckets - 1; i >= 0 ; i--) {
-			GHashTable *hash = sheet->deps->range_hash[i];
-			if (hash != NULL)
-				g_hash_table_foreach (hash,
-					&cb_recalc_all_depends, NULL);
-		}
+		g_hash_table_foreach (sheet->deps->range_hash,
+			&cb_recalc_all_depends, NULL);
 		g_hash_table_foreach (sheet->deps->single_hash,
 			&cb_recalc_all_depends, NULL);
 	} else {
-		int const first = BUCKET_OF_ROW (r->start.row);
-
 		/* mark the contained depends dirty non recursively */
 		SHEET_FOREACH_DEPENDENT (sheet, dep, {
 			GnmCell *cell = GNM_DEP_TO_CELL (dep);
@@ -1808,12 +2868,8 @@ sheet_region_queue_recalc (Sheet const *sheet, GnmRange const *r)
 		});
 
 		/* look for things that depend on target region */
-		for (i = BUCKET_OF_ROW (r->end.row); i >= first ; i--) {
-			GHashTable *hash = sheet->deps->range_hash[i];
-			if (hash != NULL)
-				g_hash_table_foreach (hash,
-					&cb_range_contained_depend, (gpointer)r);
-		}
+		deps_foreach_range_overlapping (sheet->deps, r,
+			(GnmRTreeFunc) &cb_range_contained_depend, NULL);
 		g_hash_table_foreach (sheet->deps->single_hash,
 			&cb_single_contained_depend, (gpointer)r);
 	}
@@ -1907,18 +2963,26 @@ dependents_unrelocate (GSList *info)
 void
 dependents_link (GSList *deps)
 {
-	GSList *ptr = deps;
+	GSList *ptr, *linked = NULL, *wbs = NULL;
 
 	/* put them back */
-	for (; ptr != NULL ; ptr = ptr->next) {
+	for (ptr = deps; ptr != NULL ; ptr = ptr->next) {
 		GnmDependent *dep = ptr->data;
 		if (dep->sheet->being_invalidated)
 			continue;
 		if (dep->sheet->deps != NULL && !dependent_is_linked (dep)) {
+			wbs = deps_batch_begin (wbs, dep->sheet->workbook);
 			dependent_link (dep);
-			dependent_queue_recalc (dep);
+			linked = g_slist_prepend (linked, dep);
 		}
 	}
+	deps_batch_end (wbs);
+
+	/* Queue them once all are linked, lookups are faster once the
+	 * batch is packed.  */
+	for (ptr = linked; ptr != NULL ; ptr = ptr->next)
+		dependent_queue_recalc (ptr->data);
+	g_slist_free (linked);
 }
 
 typedef struct {
@@ -1926,20 +2990,18 @@ typedef struct {
 	GSList *list;
 } CollectClosure;
 
+/* Called for the ranges that overlap the target.  */
 static void
 cb_range_contained_collect (DependencyRange const *deprange,
-			    G_GNUC_UNUSED gpointer ignored,
+			    G_GNUC_UNUSED GnmRange const *range,
 			    CollectClosure *user)
 {
-	GnmRange const *range = &deprange->range;
-
-	if (range_overlap (user->target, range))
-		micro_hash_foreach_dep (deprange->deps, dep, {
-			if (!(dep->flags & (DEPENDENT_FLAGGED | DEPENDENT_CAN_RELOCATE)) &&
-			    dependent_type (dep) != DEPENDENT_DYNAMIC_DEP) {
-				dep->flags |= DEPENDENT_FLAGGED;
-				user->list = g_slist_prepend (user->list, dep);
-			}});
+	micro_hash_foreach_dep (deprange->deps, dep, {
+		if (!(dep->flags & (DEPENDENT_FLAGGED | DEPENDENT_CAN_RELOCATE)) &&
+		    dependent_type (dep) != DEPENDENT_DYNAMIC_DEP) {
+			dep->flags |= DEPENDENT_FLAGGED;
+			user->list = g_slist_prepend (user->list, dep);
+		}});
 }
 
 static void
@@ -2031,7 +3093,6 @@ dependents_relocate (GnmExprRelocateInfo const *rinfo)
 	GSList    *l, *dependents = NULL, *undo_info = NULL;
 	Sheet	  *sheet;
 	GnmRange const   *r;
-	int i;
 	CollectClosure collect;
 	GOUndo *u_exprs, *u_names;
 
@@ -2061,17 +3122,9 @@ dependents_relocate (GnmExprRelocateInfo const *rinfo)
 	g_hash_table_foreach (sheet->deps->single_hash,
 		(GHFunc) &cb_single_contained_collect,
 		(gpointer)&collect);
-	{
-		int const first = BUCKET_OF_ROW (r->start.row);
-		GHashTable *hash;
-		for (i = BUCKET_OF_ROW (r->end.row); i >= first ; i--) {
-			hash = sheet->deps->range_hash[i];
-			if (hash != NULL)
-				g_hash_table_foreach (hash,
-					(GHFunc) &cb_range_contained_collect,
-					(gpointer)&collect);
-		}
-	}
+	deps_foreach_range_overlapping (sheet->deps, r,
+		(GnmRTreeFunc) &cb_range_contained_collect,
+		(gpointer)&collect);
 	dependents = collect.list;
 	local_rinfo = *rinfo;
 	for (l = dependents; l; l = l->next) {
@@ -2386,7 +3439,7 @@ handle_outgoing_references (GnmDepContainer *deps, Sheet *sheet)
 	what |= (sheet->workbook && sheet->workbook->during_destruction)
 		? DEPENDENT_GOES_INTERBOOK
 		: DEPENDENT_GOES_INTERSHEET;
-	DEPENDENT_CONTAINER_FOREACH_DEPENDENT (deps, dep, {
+	DEPENDENT_CONTAINER_FOREACH_DEPENDENT_SAFE (deps, dep, {
 		if (dependent_is_linked (dep) && (dep->flags & what)) {
 			dependent_unlink (dep);
 			if (sheet->revive)
@@ -2410,7 +3463,6 @@ do_deps_destroy (Sheet *sheet)
 {
 	GnmDepContainer *deps;
 	GSList *dyn_deps = NULL;
-	int i;
 
 	g_return_if_fail (IS_SHEET (sheet));
 	g_return_if_fail (sheet->being_invalidated);
@@ -2443,15 +3495,16 @@ do_deps_destroy (Sheet *sheet)
 		sheet->revive = NULL;
 	}
 
-	for (i = deps->buckets - 1; i >= 0 ; i--) {
-		GHashTable *hash = deps->range_hash[i];
-		if (hash != NULL)
-			dep_hash_destroy (hash, &dyn_deps, sheet);
-	}
+	dep_hash_destroy (deps->range_hash, &dyn_deps, sheet);
 	dep_hash_destroy (deps->single_hash, &dyn_deps, sheet);
 
-	g_free (deps->range_hash);
 	deps->range_hash = NULL;
+	gnm_rtree_free (deps->range_tree);
+	deps->range_tree = NULL;
+	gnm_rtree_free (deps->col_tree);
+	deps->col_tree = NULL;
+	gnm_rtree_free (deps->row_tree);
+	deps->row_tree = NULL;
 	/*
 	 * Note: we have not freed the elements in the pool.  This call
 	 * frees everything in one go.
@@ -2482,6 +3535,13 @@ do_deps_destroy (Sheet *sheet)
 	 */
 	handle_outgoing_references (deps, sheet);
 
+	g_ptr_array_free (deps->linked_order, TRUE);
+	deps->linked_order = NULL;
+	g_hash_table_destroy (deps->dirty);
+	deps->dirty = NULL;
+	g_hash_table_destroy (deps->volatile_deps);
+	deps->volatile_deps = NULL;
+
 	g_free (deps);
 }
 
@@ -2494,7 +3554,6 @@ do_deps_invalidate (Sheet *sheet)
 {
 	GnmDepContainer *deps;
 	GSList *dyn_deps = NULL;
-	int i;
 
 	g_return_if_fail (IS_SHEET (sheet));
 	g_return_if_fail (sheet->being_invalidated);
@@ -2506,11 +3565,7 @@ do_deps_invalidate (Sheet *sheet)
 
 	deps = sheet->deps;
 
-	for (i = deps->buckets - 1; i >= 0 ; i--) {
-		GHashTable *hash = deps->range_hash[i];
-		if (hash != NULL)
-			dep_hash_destroy (hash, &dyn_deps, sheet);
-	}
+	dep_hash_destroy (deps->range_hash, &dyn_deps, sheet);
 	dep_hash_destroy (deps->single_hash, &dyn_deps, sheet);
 
 	/* Now that we have tossed all deps to this sheet we can queue the
@@ -2569,7 +3624,7 @@ tweak_3d (Sheet *sheet)
 static void
 dependents_invalidate_sheets (GSList *sheets, gboolean destroy)
 {
-	GSList *tmp;
+	GSList *tmp, *wbs;
 	Workbook *last_wb;
 
 	/* Mark all first.  */
@@ -2594,6 +3649,11 @@ dependents_invalidate_sheets (GSList *sheets, gboolean destroy)
 	}
 
 	/* Now invalidate.  */
+	wbs = NULL;
+	for (tmp = sheets; tmp; tmp = tmp->next) {
+		Sheet *sheet = tmp->data;
+		wbs = deps_batch_begin (wbs, sheet->workbook);
+	}
 	for (tmp = sheets; tmp; tmp = tmp->next) {
 		Sheet *sheet = tmp->data;
 		if (destroy)
@@ -2601,72 +3661,387 @@ dependents_invalidate_sheets (GSList *sheets, gboolean destroy)
 		else
 			do_deps_invalidate (sheet);
 	}
+	deps_batch_end (wbs);
+
+	/* Unmark.  */
+	for (tmp = sheets; tmp; tmp = tmp->next) {
+		Sheet *sheet = tmp->data;
+		sheet->being_invalidated = FALSE;
+	}
+}
+
+void
+dependents_invalidate_sheet (Sheet *sheet, gboolean destroy)
+{
+	GSList l;
+
+	g_return_if_fail (IS_SHEET (sheet));
+
+	l.next = NULL;
+	l.data = sheet;
+	dependents_invalidate_sheets (&l, destroy);
+}
+
+void
+dependents_workbook_destroy (Workbook *wb)
+{
+	g_return_if_fail (IS_WORKBOOK (wb));
+	g_return_if_fail (wb->during_destruction);
+	g_return_if_fail (wb->sheets != NULL);
+
+	if (wb->recalc_idle != 0) {
+		g_source_remove (wb->recalc_idle);
+		wb->recalc_idle = 0;
+	}
+
+	/* Mark all first.  */
+	WORKBOOK_FOREACH_SHEET (wb, sheet, sheet->being_invalidated = TRUE;);
+
+	/* Kill 3d deps and workbook-level names, if needed.  */
+	if (wb->sheet_order_dependents) {
+		g_hash_table_destroy (wb->sheet_order_dependents);
+		wb->sheet_order_dependents = NULL;
+	}
+	gnm_named_expr_collection_free (wb->names);
+	wb->names = NULL;
+
+	WORKBOOK_FOREACH_SHEET (wb, sheet, do_deps_destroy (sheet););
+
+	/* Unmark.  */
+	WORKBOOK_FOREACH_SHEET (wb, sheet, sheet->being_invalidated = FALSE;);
+}
+
+/*
+ * dependents_revive_sheet:
+ * Undo the effects of dependents_invalidate_sheet (sheet, FALSE).
+ */
+void
+dependents_revive_sheet (Sheet *sheet)
+{
+	go_undo_undo (GO_UNDO (sheet->revive));
+	g_object_unref (sheet->revive);
+	sheet->revive = NULL;
+
+	/* Re-link local names.  */
+	gnm_named_expr_collection_relink (sheet->names);
+
+	gnm_dep_container_sanity_check (sheet->deps);
+}
+
+/**************************************************************************/
+/*
+ * Parallel recalc
+ *
+ * The dirty part of the dependency graph is sorted into levels such that
+ * no member of a level uses the value of another member of the same level.
+ * Formulas that compile (see expr-code.c) without function calls are
+ * evaluated by a pool of worker threads one level at a time.  The workers
+ * only read cell values and never allocate GnmValues; the results are
+ * stored on the main thread.  Everything else, including any formula a
+ * worker gives up on, is evaluated the usual way.  Dependents that are
+ * part of a cycle never reach a level and are handled at the end.
+ */
+
+#define RECALC_PARALLEL_MIN	256	/* Don't bother for less than this. */
+#define RECALC_CHUNK_SIZE	128
+
+typedef struct _RecalcNode RecalcNode;
+struct _RecalcNode {
+	GnmDependent *dep;
+	GSList	     *succ;
+	int	      pending;
+	GnmExprCode const *code;
+	gboolean      done;
+	gboolean      is_bool;
+	gnm_float     res;
+};
+
+typedef struct {
+	RecalcNode **nodes;
+	int	     n;
+	GMutex	    *lock;
+	GCond	    *cond;
+	int	    *outstanding;
+} RecalcChunk;
+
+/**
+ * gnm_dep_set_recalc_threads :
+ * @n : number of worker threads
+ *
+ * Use up to @n worker threads to evaluate simple numeric formulas during
+ * recalc.  A value of 1 or less disables parallel recalc.
+ */
+void
+gnm_dep_set_recalc_threads (int n)
+{
+	recalc_threads = MAX (n, 1);
+	if (recalc_pool != NULL && recalc_threads > 1)
+		g_thread_pool_set_max_threads (recalc_pool, recalc_threads, NULL);
+}
+
+/* The compiled form of @dep if a worker thread can evaluate it.  */
+static GnmExprCode const *
+dependent_get_code (GnmDependent const *dep)
+{
+	if (!dependent_is_cell (dep) ||
+	    (dep->flags & DEPENDENT_HAS_DYNAMIC_DEPS))
+		return NULL;
+
+	return gnm_expr_top_get_code (dep->texpr);
+}
+
+static void
+cb_recalc_worker (RecalcChunk *chunk, G_GNUC_UNUSED gpointer user)
+{
+	int i;
+
+	for (i = 0; i < chunk->n; i++) {
+		RecalcNode *node = chunk->nodes[i];
+		GnmEvalPos ep;
+
+		eval_pos_init_cell (&ep, GNM_DEP_TO_CELL (node->dep));
+		node->done = gnm_expr_code_eval (node->code, &ep,
+						 GNM_EXPR_CODE_NO_RECURSE,
+						 &node->res, &node->is_bool);
+	}
+
+	g_mutex_lock (chunk->lock);
+	if (--(*chunk->outstanding) == 0)
+		g_cond_signal (chunk->cond);
+	g_mutex_unlock (chunk->lock);
+}
+
+/* Hand @batch to the workers and wait for all of them to finish.  */
+static void
+recalc_numeric_batch (GPtrArray *batch)
+{
+	RecalcChunk *chunks;
+	GMutex *lock;
+	GCond *cond;
+	int i, n_chunks, outstanding;
+
+	if (recalc_pool == NULL) {
+		recalc_pool = g_thread_pool_new ((GFunc)cb_recalc_worker, NULL,
+						 recalc_threads, FALSE, NULL);
+		if (recalc_pool == NULL)
+			return;
+	}
+
+	n_chunks = (batch->len + RECALC_CHUNK_SIZE - 1) / RECALC_CHUNK_SIZE;
+	chunks = g_new (RecalcChunk, n_chunks);
+	lock = g_mutex_new ();
+	cond = g_cond_new ();
+	outstanding = n_chunks;
+
+	g_mutex_lock (lock);
+	for (i = 0; i < n_chunks; i++) {
+		RecalcChunk *chunk = chunks + i;
+		chunk->nodes = (RecalcNode **)batch->pdata + i * RECALC_CHUNK_SIZE;
+		chunk->n = MIN (RECALC_CHUNK_SIZE,
+				(int)batch->len - i * RECALC_CHUNK_SIZE);
+		chunk->lock = lock;
+		chunk->cond = cond;
+		chunk->outstanding = &outstanding;
+		g_thread_pool_push (recalc_pool, chunk, NULL);
+	}
+	while (outstanding > 0)
+		g_cond_wait (cond, lock);
+	g_mutex_unlock (lock);
+
+	g_cond_free (cond);
+	g_mutex_free (lock);
+	g_free (chunks);
+}
+
+typedef struct {
+	GHashTable *index;
+	RecalcNode *from;
+} RecalcSuccClosure;
+
+static void
+cb_recalc_collect_succ (GnmDependent *dep, RecalcSuccClosure *closure)
+{
+	RecalcNode *to;
+
+	if (dependent_type (dep) == DEPENDENT_DYNAMIC_DEP)
+		dep = ((DynamicDep *)dep)->container;
+
+	to = g_hash_table_lookup (closure->index, dep);
+	if (to != NULL && to != closure->from) {
+		closure->from->succ = g_slist_prepend (closure->from->succ, to);
+		to->pending++;
+	}
+}
+
+static void
+recalc_node_commit (RecalcNode *node)
+{
+	GnmCell *cell = GNM_DEP_TO_CELL (node->dep);
+
+	cell_assign_computed_number (cell, node->res, node->is_bool);
+	node->dep->flags &= ~(DEPENDENT_NEEDS_RECALC | DEPENDENT_CHECK_INPUTS |
+			      GNM_CELL_HAS_NEW_EXPR);
+}
+
+/*
+ * Evaluate the dirty dependents in @deps level by level.  Returns TRUE if
+ * anything was evaluated.
+ */
+static gboolean
+recalc_parallel (GPtrArray *deps)
+{
+	RecalcNode *nodes;
+	GHashTable *index;
+	GPtrArray *level, *next, *batch, *tmp;
+	RecalcSuccClosure closure;
+	guint i, n = deps->len;
+
+	nodes = g_new0 (RecalcNode, n);
+	index = g_hash_table_new (g_direct_hash, g_direct_equal);
+	for (i = 0; i < n; i++) {
+		nodes[i].dep = g_ptr_array_index (deps, i);
+		nodes[i].code = dependent_get_code (nodes[i].dep);
+		g_hash_table_insert (index, nodes[i].dep, nodes + i);
+	}
+
+	closure.index = index;
+	for (i = 0; i < n; i++) {
+		if (!dependent_is_cell (nodes[i].dep))
+			continue;
+		closure.from = nodes + i;
+		cell_foreach_dep (GNM_DEP_TO_CELL (nodes[i].dep),
+				  (DepFunc)cb_recalc_collect_succ, &closure);
+	}
+
+	level = g_ptr_array_new ();
+	next = g_ptr_array_new ();
+	batch = g_ptr_array_new ();
+	for (i = 0; i < n; i++)
+		if (nodes[i].pending == 0)
+			g_ptr_array_add (level, nodes + i);
+
+	while (level->len > 0) {
+		g_ptr_array_set_size (batch, 0);
+		for (i = 0; i < level->len; i++) {
+			RecalcNode *node = g_ptr_array_index (level, i);
+			/* Leave the ones that may not need it to dependent_eval.  */
+			if (node->code != NULL &&
+			    dependent_needs_recalc (node->dep) &&
+			    !(node->dep->flags & DEPENDENT_CHECK_INPUTS))
+				g_ptr_array_add (batch, node);
+		}
+		if (batch->len >= RECALC_CHUNK_SIZE)
+			recalc_numeric_batch (batch);
+
+		for (i = 0; i < level->len; i++) {
+			RecalcNode *node = g_ptr_array_index (level, i);
+			GSList *l;
 
-	/* Unmark.  */
-	for (tmp = sheets; tmp; tmp = tmp->next) {
-		Sheet *sheet = tmp->data;
-		sheet->being_invalidated = FALSE;
+			if (dependent_needs_recalc (node->dep)) {
+				if (node->done)
+					recalc_node_commit (node);
+				else
+					dependent_eval (node->dep);
+			}
+
+			for (l = node->succ; l != NULL; l = l->next) {
+				RecalcNode *s = l->data;
+				if (--s->pending == 0)
+					g_ptr_array_add (next, s);
+			}
+		}
+
+		tmp = level;
+		level = next;
+		next = tmp;
+		g_ptr_array_set_size (next, 0);
 	}
+
+	/* Whatever is left is part of, or downstream from, a cycle.  */
+	for (i = 0; i < n; i++)
+		if (nodes[i].pending > 0 && dependent_needs_recalc (nodes[i].dep))
+			dependent_eval (nodes[i].dep);
+
+	for (i = 0; i < n; i++)
+		g_slist_free (nodes[i].succ);
+	g_ptr_array_free (batch, TRUE);
+	g_ptr_array_free (next, TRUE);
+	g_ptr_array_free (level, TRUE);
+	g_hash_table_destroy (index);
+	g_free (nodes);
+
+	return n > 0;
 }
 
+/**************************************************************************/
+
 void
-dependents_invalidate_sheet (Sheet *sheet, gboolean destroy)
+workbook_queue_all_recalc (Workbook *wb)
 {
-	GSList l;
-
-	g_return_if_fail (IS_SHEET (sheet));
+	/* FIXME: what about dependents in other workbooks?  */
+	WORKBOOK_FOREACH_DEPENDENT (wb, dep, dependent_flag_recalc (dep););
+}
 
-	l.next = NULL;
-	l.data = sheet;
-	dependents_invalidate_sheets (&l, destroy);
+static void
+cb_collect_volatile (GnmDependent *dep, G_GNUC_UNUSED gpointer value,
+		     GSList **accum)
+{
+	*accum = g_slist_prepend (*accum, dep);
 }
 
+/**
+ * workbook_queue_volatile_recalc :
+ * @wb :
+ *
+ * Queues the dependents in @wb that call volatile functions, such as now()
+ * or rand(), and everything that depends on them for recalc.
+ */
 void
-dependents_workbook_destroy (Workbook *wb)
+workbook_queue_volatile_recalc (Workbook *wb)
 {
-	g_return_if_fail (IS_WORKBOOK (wb));
-	g_return_if_fail (wb->during_destruction);
-	g_return_if_fail (wb->sheets != NULL);
+	GSList *deps = NULL;
 
-	/* Mark all first.  */
-	WORKBOOK_FOREACH_SHEET (wb, sheet, sheet->being_invalidated = TRUE;);
+	g_return_if_fail (IS_WORKBOOK (wb));
 
-	/* Kill 3d deps and workbook-level names, if needed.  */
-	if (wb->sheet_order_dependents) {
-		g_hash_table_destroy (wb->sheet_order_dependents);
-		wb->sheet_order_dependents = NULL;
-	}
-	gnm_named_expr_collection_free (wb->names);
-	wb->names = NULL;
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		if (sheet->deps != NULL)
+			g_hash_table_foreach (sheet->deps->volatile_deps,
+					      (GHFunc)cb_collect_volatile,
+					      &deps);
+	});
 
-	WORKBOOK_FOREACH_SHEET (wb, sheet, do_deps_destroy (sheet););
+	dependent_queue_recalc_list (deps);
+	g_slist_free (deps);
+}
 
-	/* Unmark.  */
-	WORKBOOK_FOREACH_SHEET (wb, sheet, sheet->being_invalidated = FALSE;);
+static void
+cb_collect_dirty (GnmDependent *dep, G_GNUC_UNUSED gpointer value,
+		  GPtrArray *accum)
+{
+	if (dependent_needs_recalc (dep))
+		g_ptr_array_add (accum, dep);
 }
 
 /*
- * dependents_revive_sheet:
- * Undo the effects of dependents_invalidate_sheet (sheet, FALSE).
+ * Collect the dependents of @wb that still need a recalc and empty the
+ * dirty sets.  Dependents flagged while the result is being evaluated
+ * will be picked up by the next recalc.
  */
-void
-dependents_revive_sheet (Sheet *sheet)
+static GPtrArray *
+workbook_collect_dirty (Workbook *wb)
 {
-	go_undo_undo (GO_UNDO (sheet->revive));
-	g_object_unref (sheet->revive);
-	sheet->revive = NULL;
-
-	/* Re-link local names.  */
-	gnm_named_expr_collection_relink (sheet->names);
-
-	gnm_dep_container_sanity_check (sheet->deps);
-}
+	GPtrArray *accum = g_ptr_array_new ();
+
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		GnmDepContainer *deps = sheet->deps;
+		if (deps != NULL && g_hash_table_size (deps->dirty) > 0) {
+			g_hash_table_foreach (deps->dirty,
+					      (GHFunc)cb_collect_dirty, accum);
+			g_hash_table_remove_all (deps->dirty);
+		}
+	});
 
-void
-workbook_queue_all_recalc (Workbook *wb)
-{
-	/* FIXME: what about dependents in other workbooks?  */
-	WORKBOOK_FOREACH_DEPENDENT (wb, dep, dependent_flag_recalc (dep););
+	return accum;
 }
 
 /**
@@ -2682,16 +4057,38 @@ void
 workbook_recalc (Workbook *wb)
 {
 	gboolean redraw = FALSE;
+	GPtrArray *deps;
 
 	g_return_if_fail (IS_WORKBOOK (wb));
 
+	/* Everything the idle handler still had to do is done here.  */
+	if (wb->recalc_idle != 0) {
+		g_source_remove (wb->recalc_idle);
+		wb->recalc_idle = 0;
+	}
+
 	gnm_app_recalc_start ();
 
-	WORKBOOK_FOREACH_DEPENDENT (wb, dep, {
-		if (dependent_needs_recalc (dep)) {
-			redraw = TRUE;
-			dependent_eval (dep);
+	deps = workbook_collect_dirty (wb);
+	/* The workers are invisible to the profiler.  */
+	if (recalc_threads > 1 && deps->len >= RECALC_PARALLEL_MIN &&
+	    !gnm_recalc_profiling)
+		redraw = recalc_parallel (deps);
+	else {
+		guint i;
+		for (i = 0; i < deps->len; i++) {
+			GnmDependent *dep = g_ptr_array_index (deps, i);
+			if (dependent_needs_recalc (dep)) {
+				redraw = TRUE;
+				dependent_eval (dep);
+			}
 		}
+	}
+	g_ptr_array_free (deps, TRUE);
+
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		if (sheet->deps != NULL)
+			dep_container_check_clean (sheet->deps);
 	});
 
 	gnm_app_recalc_finish ();
@@ -2724,6 +4121,229 @@ workbook_recalc_all (Workbook *wb)
 		sheet_update (wb_view_cur_sheet (view)););
 }
 
+static GnmValue *
+cb_recalc_cone (GnmCellIter const *iter, G_GNUC_UNUSED gpointer user)
+{
+	gnm_cell_eval (iter->cell);
+	return NULL;
+}
+
+static void
+cb_collect_dirty_relays (GnmDependent *dep, G_GNUC_UNUSED gpointer value,
+			 GPtrArray *accum)
+{
+	int const t = dependent_type (dep);
+	if ((t == DEPENDENT_DYNAMIC_DEP ||
+	     t == DEPENDENT_NAME ||
+	     t == DEPENDENT_MANAGED) &&
+	    dependent_needs_recalc (dep))
+		g_ptr_array_add (accum, dep);
+}
+
+/**
+ * workbook_recalc_cone :
+ * @wb :
+ * @targets : a list of GnmSheetRange
+ *
+ * Computes the dirty cells in @targets and, on demand, the dirty cells
+ * they depend on.  Everything else in @wb is left dirty, which is only
+ * useful when nothing else is going to be looked at, eg. when exporting
+ * part of a workbook.
+ */
+void
+workbook_recalc_cone (Workbook *wb, GSList const *targets)
+{
+	GSList const *l;
+	GPtrArray *deps;
+	guint i;
+
+	g_return_if_fail (IS_WORKBOOK (wb));
+	for (l = targets; l != NULL ; l = l->next) {
+		GnmSheetRange const *sr = l->data;
+		g_return_if_fail (IS_SHEET (sr->sheet));
+		g_return_if_fail (sr->sheet->workbook == wb);
+	}
+
+	if (wb->recalc_idle != 0) {
+		g_source_remove (wb->recalc_idle);
+		wb->recalc_idle = 0;
+	}
+
+	gnm_app_recalc_start ();
+	for (l = targets; l != NULL ; l = l->next) {
+		GnmSheetRange const *sr = l->data;
+		sheet_foreach_cell_in_range (sr->sheet, CELL_ITER_IGNORE_BLANK,
+			sr->range.start.col, sr->range.start.row,
+			sr->range.end.col, sr->range.end.row,
+			(CellIterFunc)cb_recalc_cone, NULL);
+	}
+
+	/*
+	 * Dynamic deps, names and managed dependents only relay changes,
+	 * and they stop doing that while they are dirty.  Evaluating them
+	 * costs nothing and pulls in no cells, so do all of them rather
+	 * than work out which ones the cells above reached.  The dirty
+	 * sets must keep the rest, so do not use workbook_collect_dirty.
+	 */
+	deps = g_ptr_array_new ();
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		if (sheet->deps != NULL)
+			g_hash_table_foreach (sheet->deps->dirty,
+					      (GHFunc)cb_collect_dirty_relays,
+					      deps);
+	});
+	for (i = 0; i < deps->len; i++) {
+		GnmDependent *dep = g_ptr_array_index (deps, i);
+		dependent_eval (dep);
+		g_hash_table_remove (dep->sheet->deps->dirty, dep);
+	}
+	g_ptr_array_free (deps, TRUE);
+	gnm_app_recalc_finish ();
+}
+
+/*****************************************************************************
+ * Incremental recalc
+ *
+ * In automatic mode a command that dirties a large part of a workbook
+ * would block the main loop until workbook_recalc returned.  Instead the
+ * dirty sets are worked off from an idle handler in slices of bounded
+ * duration.  Input and redraws have a higher priority than the handler so
+ * edits get in between slices; they simply add to the dirty sets the
+ * handler is draining.  Cells whose value changed are repainted at the
+ * end of each slice.
+ *
+ * Anything that needs final values calls workbook_recalc, which finishes
+ * the job synchronously and removes the handler.
+ */
+
+#define RECALC_IDLE_MIN		1000	/* dirty dependents */
+#define RECALC_SLICE_SECONDS	0.04
+#define RECALC_SLICE_BATCH	64
+
+typedef struct {
+	GnmDependent *deps[RECALC_SLICE_BATCH];
+	int n;
+} RecalcBatch;
+
+static gboolean
+cb_recalc_batch_fill (GnmDependent *dep, G_GNUC_UNUSED gpointer value,
+		      RecalcBatch *batch)
+{
+	batch->deps[batch->n++] = dep;
+	return batch->n == RECALC_SLICE_BATCH;
+}
+
+static void
+cb_recalc_redraw (Sheet *sheet, GnmRange *r, G_GNUC_UNUSED gpointer user)
+{
+	sheet_redraw_range (sheet, r);
+}
+
+static guint
+workbook_dirty_count (Workbook *wb)
+{
+	guint n = 0;
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		if (sheet->deps != NULL)
+			n += g_hash_table_size (sheet->deps->dirty);
+	});
+	return n;
+}
+
+static gboolean
+cb_recalc_slice (Workbook *wb)
+{
+	GTimer *timer = g_timer_new ();
+	gboolean more = FALSE, expired = FALSE;
+
+	recalc_changed = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+						NULL, g_free);
+	gnm_app_recalc_start ();
+
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		GHashTable *dirty = (sheet->deps != NULL) ? sheet->deps->dirty : NULL;
+
+		while (!expired && dirty != NULL && g_hash_table_size (dirty) > 0) {
+			RecalcBatch batch;
+			int i;
+
+			batch.n = 0;
+			g_hash_table_find (dirty, (GHRFunc)cb_recalc_batch_fill, &batch);
+
+			/* Evaluating one member of the batch can unlink
+			 * another, in which case it has left the dirty set
+			 * too.  Check before touching it.  */
+			for (i = 0; i < batch.n; i++) {
+				GnmDependent *dep = batch.deps[i];
+				if (g_hash_table_remove (dirty, dep) &&
+				    dependent_needs_recalc (dep))
+					dependent_eval (dep);
+			}
+
+			expired = g_timer_elapsed (timer, NULL) > RECALC_SLICE_SECONDS;
+		}
+		if (dirty != NULL && g_hash_table_size (dirty) > 0)
+			more = TRUE;
+		else if (dirty != NULL)
+			dep_container_check_clean (sheet->deps);
+	});
+
+	gnm_app_recalc_finish ();
+	g_timer_destroy (timer);
+
+	g_hash_table_foreach (recalc_changed, (GHFunc)cb_recalc_redraw, NULL);
+	g_hash_table_destroy (recalc_changed);
+	recalc_changed = NULL;
+
+	if (more)
+		return TRUE;
+
+	wb->recalc_idle = 0;
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		SHEET_FOREACH_VIEW (sheet, sv, sv_flag_selection_change (sv););
+		sheet_update (sheet);
+	});
+	return FALSE;
+}
+
+/**
+ * workbook_recalc_incremental :
+ * @wb :
+ *
+ * Like workbook_recalc, but if there is a lot to do evaluate it in time
+ * slices from the main loop.  Only useful when there is a main loop.
+ */
+void
+workbook_recalc_incremental (Workbook *wb)
+{
+	g_return_if_fail (IS_WORKBOOK (wb));
+
+	if (wb->recalc_idle != 0)
+		return;	/* The handler picks up the new work.  */
+
+	if (workbook_dirty_count (wb) < RECALC_IDLE_MIN) {
+		workbook_recalc (wb);
+		return;
+	}
+
+	wb->recalc_idle = g_idle_add ((GSourceFunc)cb_recalc_slice, wb);
+}
+
+/**
+ * workbook_recalc_flush :
+ * @wb :
+ *
+ * Finish an incremental recalc, if one is in progress.
+ */
+void
+workbook_recalc_flush (Workbook *wb)
+{
+	g_return_if_fail (IS_WORKBOOK (wb));
+
+	if (wb->recalc_idle != 0)
+		workbook_recalc (wb);
+}
+
 static void
 dynamic_dep_free (DynamicDep *dyn)
 {
@@ -2732,6 +4352,9 @@ dynamic_dep_free (DynamicDep *dyn)
 	GnmRangeRef *rr;
 	GSList *ptr;
 
+	/* First, as it skips what the current lists still hold.  */
+	dynamic_dep_unlink_old (dyn);
+
 	for (ptr = dyn->singles ; ptr != NULL ; ptr = ptr->next) {
 		rr = ptr->data;
 		unlink_single_dep (&dyn->base, pos, &rr->a);
@@ -2747,21 +4370,46 @@ dynamic_dep_free (DynamicDep *dyn)
 	}
 	g_slist_free (dyn->ranges);
 	dyn->ranges = NULL;
+	g_hash_table_destroy (dyn->requested);
 
 	if (dyn->base.flags & DEPENDENT_HAS_3D)
 		workbook_unlink_3d_dep (&dyn->base);
 	g_free (dyn);
 }
 
+/**
+ * gnm_dep_container_end_safe_walk :
+ * @deps :
+ *
+ * Ends a DEPENDENT_CONTAINER_FOREACH_DEPENDENT_SAFE walk, catching up on
+ * the compaction it held off.
+ **/
+void
+gnm_dep_container_end_safe_walk (GnmDepContainer *deps)
+{
+	g_return_if_fail (deps->safe_walks > 0);
+
+	deps->safe_walks--;
+	linked_order_maybe_compact (deps);
+}
+
 GnmDepContainer *
 gnm_dep_container_new (Sheet *sheet)
 {
 	GnmDepContainer *deps = g_new (GnmDepContainer, 1);
 
-	deps->head = deps->tail = NULL;
-
-	deps->buckets = 1 + BUCKET_OF_ROW (gnm_sheet_get_last_row (sheet));
-	deps->range_hash  = g_new0 (GHashTable *, deps->buckets);
+	deps->linked_order = g_ptr_array_new ();
+	deps->n_unlinked = 0;
+	deps->safe_walks = 0;
+	deps->has_dirty_area = FALSE;
+
+	deps->range_hash  = g_hash_table_new ((GHashFunc) deprange_hash,
+					      (GEqualFunc) deprange_equal);
+	deps->range_tree  = gnm_rtree_new ();
+	deps->col_tree    = gnm_rtree_new ();
+	deps->row_tree    = gnm_rtree_new ();
+	deps->max_cols    = gnm_sheet_get_max_cols (sheet);
+	deps->max_rows    = gnm_sheet_get_max_rows (sheet);
 	deps->range_pool  = go_mem_chunk_new ("range pool",
 					       sizeof (DependencyRange),
 					       16 * 1024 - 100);
@@ -2776,31 +4424,77 @@ gnm_dep_container_new (Sheet *sheet)
 	deps->dynamic_deps = g_hash_table_new_full (g_direct_hash, g_direct_equal,
 		NULL, (GDestroyNotify) dynamic_dep_free);
 
+	deps->dirty = g_hash_table_new (g_direct_hash, g_direct_equal);
+	deps->volatile_deps = g_hash_table_new (g_direct_hash, g_direct_equal);
+
 	return deps;
 }
 
+static void
+cb_reindex_range (G_GNUC_UNUSED gpointer key, DependencyRange *dr,
+		  GnmDepContainer *deps)
+{
+	deprange_index (deps, dr);
+}
+
+/*
+ * Whether a range spans whole columns or rows depends on the size of the
+ * sheet, so index everything that is left afresh.
+ */
 void
-gnm_dep_container_resize (GnmDepContainer *deps, int rows)
-{
-	int i, buckets = 1 + BUCKET_OF_ROW (rows - 1);
-
-	for (i = buckets; i < deps->buckets; i++) {
-		GHashTable *hash = deps->range_hash[i];
-		if (hash != NULL) {
-			int s = g_hash_table_size (hash);
-			if (s)
-				g_printerr ("Hash table size: %d\n", s);
-			g_hash_table_destroy (hash);
-			deps->range_hash[i] = NULL;
-		}
-	}
+gnm_dep_container_resize (GnmDepContainer *deps, int cols, int rows)
+{
+	g_return_if_fail (deps != NULL);
+
+	gnm_rtree_free (deps->range_tree);
+	gnm_rtree_free (deps->col_tree);
+	gnm_rtree_free (deps->row_tree);
+	deps->range_tree = gnm_rtree_new ();
+	deps->col_tree = gnm_rtree_new ();
+	deps->row_tree = gnm_rtree_new ();
+
+	deps->max_cols = cols;
+	deps->max_rows = rows;
+	dep_container_begin_batch (deps);
+	g_hash_table_foreach (deps->range_hash,
+			      (GHFunc) cb_reindex_range, deps);
+	dep_container_end_batch (deps);
+}
+
+static void
+cb_compact (G_GNUC_UNUSED gpointer key, DependencyAny *depany,
+	    G_GNUC_UNUSED gpointer user)
+{
+	micro_hash_compact (&depany->deps);
+}
+
+/**
+ * gnm_dep_container_compact :
+ * @deps :
+ *
+ * Squeeze out the slack that inserting and removing lots of dependencies
+ * leaves behind.  This is worth doing after bulk edits such as loading a
+ * file.
+ */
+void
+gnm_dep_container_compact (GnmDepContainer *deps)
+{
+	g_return_if_fail (deps != NULL);
 
-	deps->range_hash = g_renew (GHashTable *, deps->range_hash, buckets);
+	g_hash_table_foreach (deps->single_hash, (GHFunc)cb_compact, NULL);
+	g_hash_table_foreach (deps->range_hash, (GHFunc)cb_compact, NULL);
+	linked_order_compact (deps);
+}
 
-	for (i = deps->buckets; i < buckets; i++)
-		deps->range_hash[i] = NULL;
+void
+dependents_compact (Workbook *wb)
+{
+	g_return_if_fail (IS_WORKBOOK (wb));
 
-	deps->buckets = buckets;
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		if (sheet->deps != NULL)
+			gnm_dep_container_compact (sheet->deps);
+	});
 }
 
 /****************************************************************************
@@ -2922,24 +4616,16 @@ void
 gnm_dep_container_dump (GnmDepContainer const *deps,
 			Sheet *sheet)
 {
-	int i;
-
 	g_return_if_fail (deps != NULL);
 
 	gnm_dep_container_sanity_check (deps);
 
-	for (i = deps->buckets - 1; i >= 0 ; i--) {
-		GHashTable *hash = deps->range_hash[i];
-		if (hash != NULL && g_hash_table_size (hash) > 0) {
-			g_printerr ("  Bucket %d (rows %d-%d): Range hash size %d: range over which cells in list depend\n",
-				    i,
-				    BUCKET_START_ROW (i) + 1,
-				    BUCKET_END_ROW (i) + 1,
-				    g_hash_table_size (hash));
-			g_hash_table_foreach (hash,
-					      dump_range_dep,
-					      sheet);
-		}
+	if (deps->range_hash && g_hash_table_size (deps->range_hash) > 0) {
+		g_printerr ("  Range hash size %d: range over which cells in list depend\n",
+			    g_hash_table_size (deps->range_hash));
+		g_hash_table_foreach (deps->range_hash,
+				      dump_range_dep,
+				      sheet);
 	}
 
 	if (deps->single_hash && g_hash_table_size (deps->single_hash) > 0) {
@@ -2986,38 +4672,127 @@ dependents_dump (Workbook *wb)
 		 });
 }
 
+/* An estimate, GHashTable's layout is private.  */
+#define HASH_BYTES(h) ((h) ? g_hash_table_size (h) * 4 * sizeof (gpointer) : 0)
+
+static void
+cb_stats_links (G_GNUC_UNUSED gpointer key, DependencyAny const *depany,
+		GnmDepContainerStats *stats)
+{
+	stats->n_links += depany->deps.num_elements;
+	stats->links += micro_hash_get_memory (&depany->deps);
+}
+
+static void
+cb_stats_dynamic (G_GNUC_UNUSED gpointer key, DynamicDep const *dyn,
+		  GnmDepContainerStats *stats)
+{
+	guint n = g_slist_length (dyn->singles) + g_slist_length (dyn->ranges) +
+		g_slist_length (dyn->old_singles) + g_slist_length (dyn->old_ranges);
+	stats->dynamic += sizeof (DynamicDep) + n * sizeof (GSList) +
+		g_hash_table_size (dyn->requested) * sizeof (GnmRangeRef) +
+		HASH_BYTES (dyn->requested);
+}
+
+/**
+ * gnm_dep_container_get_stats :
+ * @deps :
+ * @stats : filled in
+ *
+ * Estimates how much memory each part of @deps uses.  The dependents
+ * themselves are not counted, they belong to cells and names.
+ */
+void
+gnm_dep_container_get_stats (GnmDepContainer const *deps,
+			     GnmDepContainerStats *stats)
+{
+	g_return_if_fail (deps != NULL);
+	g_return_if_fail (stats != NULL);
+
+	memset (stats, 0, sizeof (*stats));
+
+	stats->n_singles = g_hash_table_size (deps->single_hash);
+	stats->singles = stats->n_singles * sizeof (DependencySingle) +
+		HASH_BYTES (deps->single_hash);
+	stats->n_ranges = g_hash_table_size (deps->range_hash);
+	stats->ranges = stats->n_ranges * sizeof (DependencyRange) +
+		HASH_BYTES (deps->range_hash);
+	stats->range_tree = gnm_rtree_get_memory (deps->range_tree) +
+		gnm_rtree_get_memory (deps->col_tree) +
+		gnm_rtree_get_memory (deps->row_tree);
+
+	g_hash_table_foreach (deps->single_hash, (GHFunc)cb_stats_links, stats);
+	g_hash_table_foreach (deps->range_hash, (GHFunc)cb_stats_links, stats);
+
+	stats->n_dynamic = g_hash_table_size (deps->dynamic_deps);
+	stats->dynamic = HASH_BYTES (deps->dynamic_deps);
+	g_hash_table_foreach (deps->dynamic_deps, (GHFunc)cb_stats_dynamic, stats);
+
+	stats->sets = deps->linked_order->len * sizeof (gpointer) +
+		HASH_BYTES (deps->dirty) +
+		HASH_BYTES (deps->volatile_deps) +
+		HASH_BYTES (deps->referencing_names);
+
+	stats->total = sizeof (GnmDepContainer) + stats->singles +
+		stats->ranges + stats->range_tree + stats->links +
+		stats->dynamic + stats->sets;
+}
+
+/**
+ * dependents_dump_stats :
+ * @wb :
+ *
+ * Print the memory used by the dependency data structures of each sheet.
+ */
+void
+dependents_dump_stats (Workbook *wb)
+{
+	GnmDepContainerStats stats;
+	gsize total = 0;
+
+	g_return_if_fail (IS_WORKBOOK (wb));
+
+	WORKBOOK_FOREACH_SHEET (wb, sheet, {
+		if (sheet->deps == NULL)
+			continue;
+		gnm_dep_container_get_stats (sheet->deps, &stats);
+		total += stats.total;
+		g_printerr ("Dependency memory for %s:\n"
+			    "  singles    %10lu bytes for %lu cells\n"
+			    "  ranges     %10lu bytes for %lu ranges\n"
+			    "  range tree %10lu bytes\n"
+			    "  links      %10lu bytes for %lu links\n"
+			    "  dynamic    %10lu bytes for %lu dependents\n"
+			    "  sets       %10lu bytes\n"
+			    "  total      %10lu bytes\n",
+			    sheet->name_unquoted,
+			    (gulong)stats.singles, (gulong)stats.n_singles,
+			    (gulong)stats.ranges, (gulong)stats.n_ranges,
+			    (gulong)stats.range_tree,
+			    (gulong)stats.links, (gulong)stats.n_links,
+			    (gulong)stats.dynamic, (gulong)stats.n_dynamic,
+			    (gulong)stats.sets,
+			    (gulong)stats.total);
+	});
+	g_printerr ("Dependency memory for the workbook: %lu bytes\n",
+		    (gulong)total);
+}
+
 void
 gnm_dep_container_sanity_check (GnmDepContainer const *deps)
 {
-	GnmDependent const *dep;
-	GHashTable *seenb4;
-
-	if (deps->head && !deps->tail)
-		g_warning ("Dependency container %p has head, but no tail.", (void *)deps);
-	if (deps->tail && !deps->head)
-		g_warning ("Dependency container %p has tail, but no head.", (void *)deps);
-	if (deps->head && deps->head->prev_dep)
-		g_warning ("Dependency container %p has head, but not at the beginning.", (void *)deps);
-	if (deps->tail && deps->tail->next_dep)
-		g_warning ("Dependency container %p has tail, but not at the end.", (void *)deps);
-
-	seenb4 = g_hash_table_new (g_direct_hash, g_direct_equal);
-	for (dep = deps->head; dep; dep = dep->next_dep) {
-		if (dep->prev_dep && (dep->prev_dep->next_dep != dep))
-			g_warning ("Dependency container %p has left double-link failure at %p.", (void *)deps, (void *)dep);
-		if (dep->next_dep && (dep->next_dep->prev_dep != dep))
-			g_warning ("Dependency container %p has right double-link failure at %p.", (void *)deps, (void *)dep);
-		if (!dep->next_dep && dep != deps->tail)
-			g_warning ("Dependency container %p ends before its tail.", (void *)deps);
+	guint i;
+
+	for (i = 0; i < deps->linked_order->len; i++) {
+		GnmDependent const *dep =
+			g_ptr_array_index (deps->linked_order, i);
+		if (dep == NULL)
+			continue;
 		if (!dependent_is_linked (dep))
 			g_warning ("Dependency container %p contains unlinked dependency %p.", (void *)deps, (void *)dep);
-		if (g_hash_table_lookup (seenb4, dep)) {
-			g_warning ("Dependency container %p is circular.", (void *)deps);
-			break;
-		}
-		g_hash_table_insert (seenb4, (gpointer)dep, (gpointer)dep);
+		if (dep->link_index != i)
+			g_warning ("Dependency %p is at %u but thinks it is at %u.", (void *)dep, i, dep->link_index);
 	}
-	g_hash_table_destroy (seenb4);
 }
 
 /**
@@ -9,11 +9,9 @@ G_BEGIN_DECLS
 
 struct _GnmDependent {
 	guint	  flags;
+	guint	  link_index;	/* in sheet->deps->linked_order, if linked */
 	Sheet	 *sheet;
 	GnmExprTop const *texpr;
-
-	/* Double-linked list.  */
-	GnmDependent *next_dep, *prev_dep;
 };
 
 typedef struct {
@@ -46,11 +44,15 @@ typedef enum {
 	DEPENDENT_ALWAYS_UNLINK    = 0x00100000,	/* what should this do ? */
 	DEPENDENT_HAS_DYNAMIC_DEPS = 0x00200000,
 	DEPENDENT_IGNORE_ARGS	   = 0x00400000,
-	DEPENDENT_LINK_FLAGS	   = 0x007ff000,
+	DEPENDENT_HAS_VOLATILE	   = 0x00800000,	/* eg now() */
+	DEPENDENT_LINK_FLAGS	   = 0x00fff000,
 
 	/* An internal utility flag */
 	DEPENDENT_FLAGGED	   = 0x01000000,
-	DEPENDENT_CAN_RELOCATE	   = 0x02000000
+	DEPENDENT_CAN_RELOCATE	   = 0x02000000,
+	/* Queued only because something upstream might change, skip the
+	 * recalc unless an input actually does.  */
+	DEPENDENT_CHECK_INPUTS	   = 0x04000000
 } DependentFlags;
 
 #define dependent_type(dep)		((dep)->flags & DEPENDENT_TYPE_MASK)
@@ -59,14 +61,24 @@ typedef enum {
 #define dependent_is_linked(dep)	((dep)->flags & DEPENDENT_IS_LINKED)
 
 struct _GnmDepContainer {
-	GnmDependent *head, *tail;
-
-	/* Large ranges hashed on 'range' to accelerate duplicate culling. This
-	 * is traversed by g_hash_table_foreach mostly.
+	/* The linked dependents in the order they were linked, NULL for
+	 * those unlinked since.  Each dependent knows its own index, which
+	 * sits in what used to be padding after its flags.  */
+	GPtrArray  *linked_order;
+	guint	    n_unlinked;		/* NULLs in linked_order */
+	guint	    safe_walks;		/* no compaction while non-zero */
+
+	/* Large ranges hashed on 'range' to accelerate duplicate culling.
+	 * The same DependencyRange records are indexed spatially in
+	 * range_tree for lookups by position, except for whole columns
+	 * and whole rows.  Those are indexed by column in col_tree and by
+	 * row in row_tree.
 	 */
-	int buckets;
-	GHashTable **range_hash;
+	GHashTable *range_hash;
+	GnmRTree   *range_tree;
+	GnmRTree   *col_tree, *row_tree;
 	GOMemChunk *range_pool;
+	int	    max_cols, max_rows;	/* what counts as whole */
 
 	/* Single ranges, this maps an GnmEvalPos * to a GSList of its
 	 * dependencies.
@@ -79,6 +91,18 @@ struct _GnmDepContainer {
 
 	/* Dynamic Deps */
 	GHashTable *dynamic_deps;
+
+	/* Linked dependents that have been flagged for recalc.  This may
+	 * contain entries that have since been evaluated.  */
+	GHashTable *dirty;
+
+	/* Bounds the cells flagged for recalc since the container was last
+	 * seen to be clean, so that clean ranges need not be searched.  */
+	GnmRange    dirty_area;
+	gboolean    has_dirty_area;
+
+	/* Linked dependents that call volatile functions */
+	GHashTable *volatile_deps;
 };
 
 typedef void (*DepFunc) (GnmDependent *dep, gpointer user);
@@ -96,6 +120,8 @@ void	 dependent_add_dynamic_dep (GnmDependent *dep, GnmRangeRef const *rr);
 
 GOUndo  *dependents_relocate	    (GnmExprRelocateInfo const *info);
 void	 dependents_link	    (GSList *deps);
+void	 dependents_batch_begin	    (Workbook *wb);
+void	 dependents_batch_end	    (Workbook *wb);
 
 void	 cell_queue_recalc	    (GnmCell *cell);
 void	 cell_foreach_dep	    (GnmCell const *cell, DepFunc func, gpointer user);
@@ -106,25 +132,79 @@ void dependents_invalidate_sheet  (Sheet *sheet, gboolean destroy);
 void dependents_workbook_destroy  (Workbook *wb);
 void dependents_revive_sheet      (Sheet *sheet);
 void workbook_queue_all_recalc	  (Workbook *wb);
+void workbook_queue_volatile_recalc (Workbook *wb);
+GSList *workbook_find_cycles	  (Workbook *wb);
+void gnm_dep_set_recalc_threads	  (int n);
 
 GnmDepContainer *gnm_dep_container_new  (Sheet *sheet);
 void		 gnm_dep_container_dump	(GnmDepContainer const *deps,
 					 Sheet *sheet);
 void dependents_dump (Workbook *wb);
 void             gnm_dep_container_sanity_check (GnmDepContainer const *deps);
-void             gnm_dep_container_resize (GnmDepContainer *deps, int rows);
+void             gnm_dep_container_resize (GnmDepContainer *deps,
+					   int cols, int rows);
+void             gnm_dep_container_compact (GnmDepContainer *deps);
+void dependents_compact (Workbook *wb);
+
+/* Approximate memory use of a GnmDepContainer, in bytes unless noted.  */
+typedef struct {
+	gsize n_singles;	/* cells that something depends on */
+	gsize singles;
+	gsize n_ranges;		/* ranges that something depends on */
+	gsize ranges;
+	gsize range_tree;
+	gsize n_links;		/* dependent entries in the above */
+	gsize links;
+	gsize n_dynamic;
+	gsize dynamic;
+	gsize sets;		/* linked, dirty, volatile and name sets */
+	gsize total;
+} GnmDepContainerStats;
+
+void gnm_dep_container_get_stats (GnmDepContainer const *deps,
+				  GnmDepContainerStats *stats);
+void dependents_dump_stats (Workbook *wb);
 
 void dependent_managed_init (GnmDependent *dep, Sheet *sheet);
 void dependent_managed_set_expr (GnmDependent *dep, GnmExprTop const *texpr);
 
+void gnm_dep_container_end_safe_walk (GnmDepContainer *deps);
+
+/*
+ * Walk the linked dependents in the order they were linked.  The code
+ * must not unlink any of them, use the _SAFE variant for that.
+ */
 #define DEPENDENT_CONTAINER_FOREACH_DEPENDENT(dc, dep, code)	\
   do {								\
-	GnmDependent *dep = (dc)->head;				\
-	while (dep) {						\
-		GnmDependent *_next = dep->next_dep;		\
+	GPtrArray const *_order = (dc)->linked_order;		\
+	guint _i;						\
+	for (_i = 0; _i < _order->len; _i++) {			\
+		GnmDependent *dep = g_ptr_array_index (_order, _i); \
+		if (dep == NULL)				\
+			continue;				\
+		code;						\
+	}							\
+  } while (0)
+
+/*
+ * Like DEPENDENT_CONTAINER_FOREACH_DEPENDENT, but the code may link,
+ * unlink and free dependents.  Those unlinked before they are reached
+ * are skipped and those linked meanwhile are visited.  The code must
+ * not return out of the loop.
+ */
+#define DEPENDENT_CONTAINER_FOREACH_DEPENDENT_SAFE(dc, dep, code) \
+  do {								\
+	GnmDepContainer *_dc = (dc);				\
+	guint _i;						\
+	_dc->safe_walks++;					\
+	for (_i = 0; _i < _dc->linked_order->len; _i++) {	\
+		GnmDependent *dep =				\
+			g_ptr_array_index (_dc->linked_order, _i); \
+		if (dep == NULL)				\
+			continue;				\
 		code;						\
-		dep = _next;					\
 	}							\
+	gnm_dep_container_end_safe_walk (_dc);			\
   } while (0)
 
 #define DEPENDENT_MAKE_TYPE(t, set_expr_handler)		\
@@ -319,6 +319,9 @@ cb_dialog_apply_clicked (G_GNUC_UNUSED GtkWidget *button,
 	if (state->warning_dialog != NULL)
 		gtk_widget_destroy (state->warning_dialog);
 
+	/* Seek from current values, not from a half finished recalc.  */
+	workbook_recalc_flush (state->wb);
+
 	/* set up source */
 	target = gnm_expr_entry_parse_as_value (state->set_cell_entry,
 						state->sheet);
@@ -30,6 +30,7 @@
 #include "help.h"
 
 #include <sheet.h>
+#include <workbook.h>
 #include <cell.h>
 #include <ranges.h>
 #include <gui-util.h>
@@ -106,6 +107,8 @@ shuffle_ok_clicked_cb (G_GNUC_UNUSED GtkWidget *button, ShuffleState *state)
 
 	type = gnm_gui_group_value (state->gui, shuffle_by);
 
+	workbook_recalc_flush (state->sheet->workbook);
+
 	ds = data_shuffling (WORKBOOK_CONTROL (state->wbcg), dao,
 			     state->sheet, input, type);
 
@@ -646,6 +646,8 @@ run_solver (SolverState *state, GnmSolverParameters *param)
 	vinput = gnm_solver_param_get_input (param);
 	gnm_sheet_range_from_value (&sr, vinput);
 	if (!sr.sheet) sr.sheet = param->sheet;
+	/* Start from current values, not from a half finished recalc.  */
+	workbook_recalc_flush (sr.sheet->workbook);
 	undo = clipboard_copy_range_undo (sr.sheet, &sr.range);
 
 	dialog = (GtkDialog *)gtk_dialog_new_with_buttons
@@ -0,0 +1,377 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+
+/*
+ * expr-code.c: Compiled numeric expressions.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+#include <gnumeric-config.h>
+#include "gnumeric.h"
+#include "expr-code.h"
+
+#include "expr.h"
+#include "expr-impl.h"
+#include "value.h"
+#include "cell.h"
+#include "sheet.h"
+#include "dependent.h"
+#include "position.h"
+
+/*
+ * Arithmetic and comparisons over numbers, booleans and cell references
+ * are compiled into a flat sequence of register instructions.
+ * Intermediate results stay unboxed in the register file.
+ *
+ * The interpreter gives up whenever the result of the tree walker would
+ * be anything but a number or a boolean (errors, strings, ranges, ...).
+ * The caller then evaluates the tree the usual way, which produces the
+ * right value, error and all.  Function calls are not compiled: any of
+ * them can return an error, and giving up would call them a second time.
+ */
+
+#define CODE_MAX_REGS	64
+
+typedef enum {
+	CODE_CONST_FLOAT,
+	CODE_CONST_BOOL,
+	CODE_CELL,
+	CODE_ADD,
+	CODE_SUB,
+	CODE_MULT,
+	CODE_DIV,
+	CODE_EXP,
+	CODE_EQUAL,
+	CODE_NOT_EQUAL,
+	CODE_GT,
+	CODE_GTE,
+	CODE_LT,
+	CODE_LTE,
+	CODE_PLUS,
+	CODE_NEG,
+	CODE_PERCENT
+} CodeOp;
+
+typedef enum {
+	CODE_KIND_EMPTY,
+	CODE_KIND_FLOAT,
+	CODE_KIND_BOOL
+} CodeKind;
+
+/*
+ * Operands live in registers @dst and up: binary operators compute
+ * @dst = @dst op @dst+1.  @idx indexes the constant or reference pool.
+ */
+typedef struct {
+	guint8	op;
+	guint8	dst;
+	guint16	idx;
+} CodeInstr;
+
+struct _GnmExprCode {
+	CodeInstr  *instrs;
+	int	    n_instrs;
+	int	    n_regs;
+	gnm_float  *consts;
+	GnmCellRef *refs;
+};
+
+typedef struct {
+	GArray *instrs, *consts, *refs;
+	int n_regs;
+} CodeCompiler;
+
+static void
+code_emit (CodeCompiler *cc, CodeOp op, int dst, int idx)
+{
+	CodeInstr i;
+	i.op = op;
+	i.dst = dst;
+	i.idx = idx;
+	g_array_append_val (cc->instrs, i);
+}
+
+static gboolean
+code_compile (CodeCompiler *cc, GnmExpr const *expr, int dst)
+{
+	CodeOp op;
+
+	if (dst >= CODE_MAX_REGS || cc->instrs->len >= G_MAXUINT16)
+		return FALSE;
+	cc->n_regs = MAX (cc->n_regs, dst + 1);
+
+	switch (GNM_EXPR_GET_OPER (expr)) {
+	case GNM_EXPR_OP_ADD:	    op = CODE_ADD; goto binary;
+	case GNM_EXPR_OP_SUB:	    op = CODE_SUB; goto binary;
+	case GNM_EXPR_OP_MULT:	    op = CODE_MULT; goto binary;
+	case GNM_EXPR_OP_DIV:	    op = CODE_DIV; goto binary;
+	case GNM_EXPR_OP_EXP:	    op = CODE_EXP; goto binary;
+	case GNM_EXPR_OP_EQUAL:	    op = CODE_EQUAL; goto binary;
+	case GNM_EXPR_OP_NOT_EQUAL: op = CODE_NOT_EQUAL; goto binary;
+	case GNM_EXPR_OP_GT:	    op = CODE_GT; goto binary;
+	case GNM_EXPR_OP_GTE:	    op = CODE_GTE; goto binary;
+	case GNM_EXPR_OP_LT:	    op = CODE_LT; goto binary;
+	case GNM_EXPR_OP_LTE:	    op = CODE_LTE;
+	binary:
+		if (!code_compile (cc, expr->binary.value_a, dst) ||
+		    !code_compile (cc, expr->binary.value_b, dst + 1))
+			return FALSE;
+		code_emit (cc, op, dst, 0);
+		return TRUE;
+
+	case GNM_EXPR_OP_PAREN:
+		return code_compile (cc, expr->unary.value, dst);
+
+	case GNM_EXPR_OP_UNARY_PLUS:  op = CODE_PLUS; goto unary;
+	case GNM_EXPR_OP_UNARY_NEG:   op = CODE_NEG; goto unary;
+	case GNM_EXPR_OP_PERCENTAGE:  op = CODE_PERCENT;
+	unary:
+		if (!code_compile (cc, expr->unary.value, dst))
+			return FALSE;
+		code_emit (cc, op, dst, 0);
+		return TRUE;
+
+	case GNM_EXPR_OP_CONSTANT: {
+		GnmValue const *v = expr->constant.value;
+		gnm_float f;
+
+		if (!VALUE_IS_NUMBER (v) || cc->consts->len >= G_MAXUINT16)
+			return FALSE;
+		f = value_get_as_float (v);
+		code_emit (cc, VALUE_IS_BOOLEAN (v)
+			   ? CODE_CONST_BOOL : CODE_CONST_FLOAT,
+			   dst, cc->consts->len);
+		g_array_append_val (cc->consts, f);
+		return TRUE;
+	}
+
+	case GNM_EXPR_OP_CELLREF:
+		if (cc->refs->len >= G_MAXUINT16)
+			return FALSE;
+		code_emit (cc, CODE_CELL, dst, cc->refs->len);
+		g_array_append_val (cc->refs, expr->cellref.ref);
+		return TRUE;
+
+	default:
+		return FALSE;
+	}
+}
+
+/**
+ * gnm_expr_code_compile :
+ * @expr : #GnmExpr
+ *
+ * Returns the compiled form of @expr or NULL if it cannot be compiled.
+ * Only expressions whose top level operator is arithmetic or a comparison
+ * are compiled, which means the result is always a plain number or
+ * boolean without a format.
+ **/
+GnmExprCode *
+gnm_expr_code_compile (GnmExpr const *expr)
+{
+	CodeCompiler cc;
+	GnmExprCode *code = NULL;
+
+	g_return_val_if_fail (expr != NULL, NULL);
+
+	while (GNM_EXPR_GET_OPER (expr) == GNM_EXPR_OP_PAREN)
+		expr = expr->unary.value;
+	switch (GNM_EXPR_GET_OPER (expr)) {
+	case GNM_EXPR_OP_ANY_BINARY:
+		if (GNM_EXPR_GET_OPER (expr) != GNM_EXPR_OP_CAT)
+			break;
+		/* Fall through.  */
+	default:
+		return NULL;
+	}
+
+	cc.instrs = g_array_new (FALSE, FALSE, sizeof (CodeInstr));
+	cc.consts = g_array_new (FALSE, FALSE, sizeof (gnm_float));
+	cc.refs = g_array_new (FALSE, FALSE, sizeof (GnmCellRef));
+	cc.n_regs = 0;
+
+	if (code_compile (&cc, expr, 0)) {
+		code = g_new (GnmExprCode, 1);
+		code->n_instrs = cc.instrs->len;
+		code->n_regs = cc.n_regs;
+		code->instrs = (CodeInstr *)g_array_free (cc.instrs, FALSE);
+		code->consts = (gnm_float *)g_array_free (cc.consts, FALSE);
+		code->refs = (GnmCellRef *)g_array_free (cc.refs, FALSE);
+	} else {
+		g_array_free (cc.instrs, TRUE);
+		g_array_free (cc.consts, TRUE);
+		g_array_free (cc.refs, TRUE);
+	}
+
+	return code;
+}
+
+void
+gnm_expr_code_free (GnmExprCode *code)
+{
+	if (code == NULL)
+		return;
+	g_free (code->instrs);
+	g_free (code->consts);
+	g_free (code->refs);
+	g_free (code);
+}
+
+static gboolean
+code_load_cell (GnmCellRef const *ref, GnmEvalPos const *ep,
+		GnmExprCodeFlags flags, gnm_float *res, CodeKind *kind)
+{
+	GnmCellRef r;
+	GnmCell *cell;
+	GnmValue const *v;
+
+	gnm_cellref_make_abs (&r, ref, ep);
+	cell = sheet_cell_get (eval_sheet (r.sheet, ep->sheet), r.col, r.row);
+	if (cell == NULL) {
+		*res = 0;
+		*kind = CODE_KIND_EMPTY;
+		return TRUE;
+	}
+
+	if (flags & GNM_EXPR_CODE_NO_RECURSE) {
+		/* Not ready yet, or in a cycle.  */
+		if (gnm_cell_needs_recalc (cell) ||
+		    (cell->base.flags & DEPENDENT_BEING_CALCULATED))
+			return FALSE;
+	} else
+		gnm_cell_eval (cell);
+
+	v = cell->value;
+	if (VALUE_IS_EMPTY (v)) {
+		*res = 0;
+		*kind = CODE_KIND_EMPTY;
+	} else if (VALUE_IS_FLOAT (v)) {
+		*res = value_get_as_float (v);
+		*kind = CODE_KIND_FLOAT;
+	} else if (VALUE_IS_BOOLEAN (v)) {
+		*res = value_get_as_checked_bool (v) ? 1 : 0;
+		*kind = CODE_KIND_BOOL;
+	} else
+		return FALSE;
+	return TRUE;
+}
+
+/**
+ * gnm_expr_code_eval :
+ * @code : compiled expression
+ * @ep : evaluation position
+ * @flags :
+ * @res : result
+ * @is_bool : set to TRUE if @res is a boolean
+ *
+ * Runs @code.  Returns FALSE if the result is not a plain number or
+ * boolean, in which case the caller must fall back to gnm_expr_eval.
+ **/
+gboolean
+gnm_expr_code_eval (GnmExprCode const *code, GnmEvalPos const *ep,
+		    GnmExprCodeFlags flags,
+		    gnm_float *res, gboolean *is_bool)
+{
+	gnm_float vals[CODE_MAX_REGS];
+	CodeKind kinds[CODE_MAX_REGS];
+	CodeInstr const *i, *end;
+
+	g_return_val_if_fail (code != NULL, FALSE);
+	g_return_val_if_fail (ep != NULL, FALSE);
+
+	for (i = code->instrs, end = i + code->n_instrs; i < end; i++) {
+		/* Binary operators find their second operand in a[1].  */
+		gnm_float *a = vals + i->dst;
+		CodeKind *ka = kinds + i->dst;
+
+		switch (i->op) {
+		case CODE_CONST_FLOAT:
+			*a = code->consts[i->idx];
+			*ka = CODE_KIND_FLOAT;
+			break;
+
+		case CODE_CONST_BOOL:
+			*a = code->consts[i->idx];
+			*ka = CODE_KIND_BOOL;
+			break;
+
+		case CODE_CELL:
+			if (!code_load_cell (code->refs + i->idx, ep, flags, a, ka))
+				return FALSE;
+			break;
+
+		/* Empties and booleans act as numbers here.  */
+		case CODE_ADD:  *a += a[1]; *ka = CODE_KIND_FLOAT; break;
+		case CODE_SUB:  *a -= a[1]; *ka = CODE_KIND_FLOAT; break;
+		case CODE_MULT: *a *= a[1]; *ka = CODE_KIND_FLOAT; break;
+		case CODE_DIV:
+			if (a[1] == 0)
+				return FALSE;
+			*a /= a[1];
+			*ka = CODE_KIND_FLOAT;
+			break;
+		case CODE_EXP:
+			if ((*a == 0 && a[1] <= 0) ||
+			    (*a < 0 && a[1] != gnm_floor (a[1])))
+				return FALSE;
+			*a = gnm_pow (*a, a[1]);
+			*ka = CODE_KIND_FLOAT;
+			break;
+
+		/* Leave mixed types to value_compare.  */
+		case CODE_EQUAL:
+		case CODE_NOT_EQUAL:
+		case CODE_GT:
+		case CODE_GTE:
+		case CODE_LT:
+		case CODE_LTE:
+			if (ka[0] != CODE_KIND_FLOAT || ka[1] != CODE_KIND_FLOAT)
+				return FALSE;
+			switch (i->op) {
+			case CODE_EQUAL:     *a = (*a == a[1]); break;
+			case CODE_NOT_EQUAL: *a = (*a != a[1]); break;
+			case CODE_GT:	     *a = (*a >  a[1]); break;
+			case CODE_GTE:	     *a = (*a >= a[1]); break;
+			case CODE_LT:	     *a = (*a <  a[1]); break;
+			default:
+			case CODE_LTE:	     *a = (*a <= a[1]); break;
+			}
+			*ka = CODE_KIND_BOOL;
+			break;
+
+		case CODE_PLUS:
+			if (*ka == CODE_KIND_EMPTY)
+				*ka = CODE_KIND_FLOAT;
+			break;
+		case CODE_NEG:
+			*a = 0 - *a;
+			*ka = CODE_KIND_FLOAT;
+			break;
+		case CODE_PERCENT:
+			*a /= 100;
+			*ka = CODE_KIND_FLOAT;
+			break;
+
+		default:
+			g_assert_not_reached ();
+		}
+
+		if (!gnm_finite (*a))
+			return FALSE;
+	}
+
+	*res = vals[0];
+	*is_bool = (kinds[0] == CODE_KIND_BOOL);
+	return TRUE;
+}
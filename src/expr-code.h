@@ -0,0 +1,26 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#ifndef _GNM_EXPR_CODE_H_
+# define _GNM_EXPR_CODE_H_
+
+#include "gnumeric.h"
+#include "numbers.h"
+
+G_BEGIN_DECLS
+
+typedef enum {
+	GNM_EXPR_CODE_DEFAULT	 = 0,
+	/* Fail rather than evaluate a precedent.  This makes
+	 * evaluation safe from worker threads.  */
+	GNM_EXPR_CODE_NO_RECURSE = 1 << 0
+} GnmExprCodeFlags;
+
+GnmExprCode *gnm_expr_code_compile	(GnmExpr const *expr);
+void	     gnm_expr_code_free		(GnmExprCode *code);
+gboolean     gnm_expr_code_eval		(GnmExprCode const *code,
+					 GnmEvalPos const *ep,
+					 GnmExprCodeFlags flags,
+					 gnm_float *res, gboolean *is_bool);
+
+G_END_DECLS
+
+#endif /* _GNM_EXPR_CODE_H_ */
@@ -20,10 +20,12 @@
 #include "workbook-priv.h"
 #include "expr.h"
 #include "expr-impl.h"
+#include "func.h"
 #include "sheet.h"
 #include "ranges.h"
 #include "gutils.h"
 #include "sheet-style.h"
+#include "application.h"
 
 #include <goffice/goffice.h>
 
@@ -464,6 +466,7 @@ expr_name_new (char const *name)
 	nexpr->is_permanent	= FALSE;
 	nexpr->is_editable	= TRUE;
 	nexpr->scope = NULL;
+	nexpr->cache = NULL;
 
 	if (gnm_debug_flag ("names"))
 		g_printerr ("Created new name %s\n", name);
@@ -542,9 +545,12 @@ expr_name_check_for_loop (char const *name, GnmExprTop const *texpr)
 	return do_expr_name_loop_check (name, NULL, texpr->expr, FALSE);
 }
 
+static void expr_name_cache_clear (GnmNamedExpr *nexpr);
+
 static void
 expr_name_queue_deps (GnmNamedExpr *nexpr)
 {
+	expr_name_cache_clear (nexpr);
 	if (nexpr->dependents)
 		g_hash_table_foreach (nexpr->dependents,
 				      (GHFunc)dependent_queue_recalc,
@@ -789,16 +795,184 @@ expr_name_as_string (GnmNamedExpr const *nexpr, GnmParsePos const *pp,
 	return gnm_expr_top_as_string (nexpr->texpr, pp, fmt);
 }
 
+/*******************************************************************
+ * Names that are referenced from many places are evaluated once per
+ * recalc.  The cached values are dropped along with the other recalc
+ * caches, see gnm_app_recalc_clear_caches, or when the name changes.
+ */
+
+static gulong name_cache_handler;
+static GHashTable *name_caches;
+
+static void
+cb_name_cache_release (GnmNamedExpr *nexpr)
+{
+	value_release (nexpr->cache);
+	nexpr->cache = NULL;
+	nexpr->cache_sheet = NULL;
+}
+
+static void
+name_caches_clear (void)
+{
+	if (!name_cache_handler)
+		return;
+
+	g_signal_handler_disconnect (gnm_app_get_app (), name_cache_handler);
+	name_cache_handler = 0;
+
+	g_hash_table_destroy (name_caches);
+	name_caches = NULL;
+}
+
+static void
+expr_name_cache_clear (GnmNamedExpr *nexpr)
+{
+	if (nexpr->cache != NULL)
+		g_hash_table_remove (name_caches, nexpr);
+}
+
+static void
+expr_name_cache_set (GnmNamedExpr *nexpr, GnmValue const *v,
+		     GnmEvalPos const *pos, GnmExprEvalFlags flags)
+{
+	if (!name_cache_handler) {
+		name_cache_handler =
+			g_signal_connect (gnm_app_get_app (),
+					  "recalc-clear-caches",
+					  G_CALLBACK (name_caches_clear), NULL);
+		name_caches = g_hash_table_new_full
+			(g_direct_hash, g_direct_equal,
+			 (GDestroyNotify)cb_name_cache_release, NULL);
+	}
+
+	nexpr->cache = value_dup (v);
+	nexpr->cache_flags = flags;
+	nexpr->cache_sheet = pos->sheet;
+	g_hash_table_insert (name_caches, nexpr, nexpr);
+}
+
+/* Functions that look at the calling position or build ranges out of
+ * thin air.  The latter add dynamic dependencies to the caller.  */
+static char const * const position_funcs[] = {
+	"address", "cell", "column", "indirect", "offset", "row"
+};
+
+static gboolean
+func_is_position_independent (GnmFunc const *func)
+{
+	unsigned i;
+
+	if (func->flags & (GNM_FUNC_VOLATILE | GNM_FUNC_IS_PLACEHOLDER))
+		return FALSE;
+	/* A linker registers the caller with something outside the sheet */
+	if (func->linker != NULL)
+		return FALSE;
+	for (i = 0; i < G_N_ELEMENTS (position_funcs); i++)
+		if (!g_ascii_strcasecmp (func->name, position_funcs[i]))
+			return FALSE;
+	return TRUE;
+}
+
+/*
+ * Does evaluating @expr give the same result no matter who asks ?
+ * Relative references move with the caller, and so does anything
+ * computed by a volatile function or one that looks at the calling
+ * position, so none of those qualify.
+ */
+static gboolean
+expr_is_position_independent (GnmExpr const *expr, int depth)
+{
+	switch (GNM_EXPR_GET_OPER (expr)) {
+	case GNM_EXPR_OP_RANGE_CTOR:
+	case GNM_EXPR_OP_INTERSECT:
+	case GNM_EXPR_OP_ANY_BINARY:
+		return (expr_is_position_independent (expr->binary.value_a, depth) &&
+			expr_is_position_independent (expr->binary.value_b, depth));
+	case GNM_EXPR_OP_ANY_UNARY:
+		return expr_is_position_independent (expr->unary.value, depth);
+	case GNM_EXPR_OP_NAME: {
+		GnmNamedExpr const *nexpr2 = expr->name.name;
+		if (!expr_name_is_active (nexpr2))
+			return TRUE;
+		/* Loops are refused when names are defined, but be safe */
+		return depth < 16 &&
+			expr_is_position_independent (nexpr2->texpr->expr,
+						      depth + 1);
+	}
+	case GNM_EXPR_OP_CELLREF:
+		return !expr->cellref.ref.col_relative &&
+			!expr->cellref.ref.row_relative;
+	case GNM_EXPR_OP_CONSTANT: {
+		GnmValue const *v = expr->constant.value;
+		if (v->type != VALUE_CELLRANGE)
+			return TRUE;
+		return !v->v_range.cell.a.col_relative &&
+			!v->v_range.cell.a.row_relative &&
+			!v->v_range.cell.b.col_relative &&
+			!v->v_range.cell.b.row_relative;
+	}
+	case GNM_EXPR_OP_SET: {
+		int i;
+		for (i = 0; i < expr->set.argc; i++)
+			if (!expr_is_position_independent (expr->set.argv[i],
+							   depth))
+				return FALSE;
+		return TRUE;
+	}
+	case GNM_EXPR_OP_FUNCALL: {
+		int i;
+		if (!func_is_position_independent (expr->func.func))
+			return FALSE;
+		for (i = 0; i < expr->func.argc; i++)
+			if (!expr_is_position_independent (expr->func.argv[i],
+							   depth))
+				return FALSE;
+		return TRUE;
+	}
+	case GNM_EXPR_OP_ARRAY_CORNER:
+	case GNM_EXPR_OP_ARRAY_ELEM:
+		break;
+	}
+	return FALSE;
+}
+
 GnmValue *
 expr_name_eval (GnmNamedExpr const *nexpr, GnmEvalPos const *pos,
 		GnmExprEvalFlags flags)
 {
+	GnmNamedExpr *ne = (GnmNamedExpr *)nexpr;
+	GnmValue *res;
+
 	g_return_val_if_fail (pos, NULL);
 
 	if (!nexpr)
 		return value_new_error_NAME (pos);
 
-	return gnm_expr_top_eval (nexpr->texpr, pos, flags);
+	/*
+	 * Only non-scalar evaluations outside of array formulae are cached.
+	 * In a scalar context ranges are intersected with the caller's
+	 * position, and in an array formula its size matters.
+	 */
+	if (!(flags & GNM_EXPR_EVAL_PERMIT_NON_SCALAR) || pos->array != NULL)
+		return gnm_expr_top_eval (nexpr->texpr, pos, flags);
+
+	if (ne->cache != NULL &&
+	    ne->cache_flags == flags && ne->cache_sheet == pos->sheet)
+		return value_dup (ne->cache);
+
+	/* Keep the cache alive for no longer than this evaluation if it
+	 * is not part of a larger recalc.  */
+	gnm_app_recalc_start ();
+	res = gnm_expr_top_eval (nexpr->texpr, pos, flags);
+	if (res != NULL &&
+	    expr_is_position_independent (nexpr->texpr->expr, 0)) {
+		expr_name_cache_clear (ne);
+		expr_name_cache_set (ne, res, pos, flags);
+	}
+	gnm_app_recalc_finish ();
+
+	return res;
 }
 
 /**
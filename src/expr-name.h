@@ -19,6 +19,11 @@ struct _GnmNamedExpr {
 	gboolean    is_permanent;
 	gboolean    is_editable;
 	GnmNamedExprCollection *scope;
+
+	/* Value of the last evaluation, kept for the rest of the recalc */
+	GnmValue   *cache;
+	GnmExprEvalFlags cache_flags;
+	Sheet	   *cache_sheet;
 };
 
 gboolean expr_name_validate (const char *name);
@@ -27,6 +27,7 @@
 
 #include "expr-impl.h"
 #include "expr-name.h"
+#include "expr-code.h"
 #include "dependent.h"
 #include "application.h"
 #include "func.h"
@@ -2818,8 +2819,10 @@ gnm_expr_top_new (GnmExpr const *expr)
 	res = g_new (GnmExprTop, 1);
 	res->magic = GNM_EXPR_TOP_MAGIC;
 	res->hash = 0;
+	res->compiled = FALSE;
 	res->refcount = 1;
 	res->expr = expr;
+	res->code = NULL;
 	return res;
 }
 
@@ -2844,6 +2847,7 @@ gnm_expr_top_unref (GnmExprTop const *texpr)
 
 	((GnmExprTop *)texpr)->refcount--;
 	if (texpr->refcount == 0) {
+		gnm_expr_code_free (texpr->code);
 		gnm_expr_free (texpr->expr);
 		((GnmExprTop *)texpr)->magic = 0;
 		g_free ((GnmExprTop *)texpr);
@@ -2858,6 +2862,25 @@ gnm_expr_top_is_shared (GnmExprTop const *texpr)
 	return texpr->refcount > 1;
 }
 
+/**
+ * gnm_expr_top_get_code :
+ * @texpr :
+ *
+ * Returns the compiled form of @texpr, compiling it on first use, or NULL
+ * if it cannot be compiled.  Must be called from the main thread.
+ **/
+GnmExprCode const *
+gnm_expr_top_get_code (GnmExprTop const *texpr)
+{
+	g_return_val_if_fail (IS_GNM_EXPR_TOP (texpr), NULL);
+
+	if (!texpr->compiled) {
+		((GnmExprTop *)texpr)->code = gnm_expr_code_compile (texpr->expr);
+		((GnmExprTop *)texpr)->compiled = TRUE;
+	}
+	return texpr->code;
+}
+
 GnmExprTop const *
 gnm_expr_top_new_array_corner (int cols, int rows, GnmExpr const *expr)
 {
@@ -3041,6 +3064,52 @@ gnm_expr_top_eval (GnmExprTop const *texpr,
 	return res;
 }
 
+/**
+ * gnm_expr_top_eval_unboxed :
+ * @texpr :
+ * @pos :
+ * @flags :
+ * @num : result
+ * @is_bool : set to TRUE if @num is a boolean
+ * @unboxed : set to TRUE if the result is in @num
+ *
+ * Like gnm_expr_top_eval, but when the compiled form of @texpr produces a
+ * number or boolean it is stored in @num, @unboxed is set, and NULL is
+ * returned.  This saves allocating a value the caller would only unpack.
+ * Otherwise @unboxed is cleared and the result of the evaluation, which
+ * may be NULL under GNM_EXPR_EVAL_PERMIT_EMPTY, is returned.
+ *
+ * Compiling only pays off for expressions that are evaluated over and
+ * over, so this is meant for the recalc of linked dependents.  One-shot
+ * evaluations should use gnm_expr_top_eval.
+ **/
+GnmValue *
+gnm_expr_top_eval_unboxed (GnmExprTop const *texpr,
+			   GnmEvalPos const *pos,
+			   GnmExprEvalFlags flags,
+			   gnm_float *num, gboolean *is_bool,
+			   gboolean *unboxed)
+{
+	GnmValue *res = NULL;
+	GnmExprCode const *code;
+
+	*unboxed = FALSE;
+	g_return_val_if_fail (IS_GNM_EXPR_TOP (texpr), NULL);
+
+	/* Implicit iteration is left to the tree walker.  */
+	code = (pos->array == NULL) ? gnm_expr_top_get_code (texpr) : NULL;
+
+	gnm_app_recalc_start ();
+	if (code != NULL &&
+	    gnm_expr_code_eval (code, pos, GNM_EXPR_CODE_DEFAULT, num, is_bool))
+		*unboxed = TRUE;
+	else
+		res = gnm_expr_eval (texpr->expr, pos, flags);
+	gnm_app_recalc_finish ();
+
+	return res;
+}
+
 /**
  * gnm_expr_top_referenced_sheets :
  * @texpr :
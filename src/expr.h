@@ -116,9 +116,11 @@ void	 gnm_expr_list_unref	  (GnmExprList *list);
 
 struct _GnmExprTop {
 	unsigned magic : 8;
-	unsigned hash : 24;  /* Zero meaning not yet computed.  */
+	unsigned hash : 23;  /* Zero meaning not yet computed.  */
+	unsigned compiled : 1;
 	guint32 refcount;
 	GnmExpr const *expr;
+	GnmExprCode *code;   /* NULL if not compiled (yet).  */
 };
 
 GnmExprTop const *gnm_expr_top_new		(GnmExpr const *e);
@@ -131,6 +133,7 @@ void		gnm_expr_top_unref		(GnmExprTop const *texpr);
 gboolean	gnm_expr_top_equal		(GnmExprTop const *te1, GnmExprTop const *te2);
 guint           gnm_expr_top_hash               (GnmExprTop const *texpr);
 gboolean	gnm_expr_top_is_shared		(GnmExprTop const *texpr);
+GnmExprCode const *gnm_expr_top_get_code	(GnmExprTop const *texpr);
 gboolean	gnm_expr_top_is_err		(GnmExprTop const *texpr, GnmStdError e);
 gboolean	gnm_expr_top_is_rangeref	(GnmExprTop const *texpr);
 gboolean	gnm_expr_top_is_array_elem	(GnmExprTop const *texpr, int *x, int *y);
@@ -181,6 +184,11 @@ GnmExprTop const * gnm_expr_top_relocate_sheet (GnmExprTop const *texpr,
 GnmValue *gnm_expr_top_eval	  (GnmExprTop const *texpr,
 				   GnmEvalPos const *pos,
 				   GnmExprEvalFlags flags);
+GnmValue *gnm_expr_top_eval_unboxed (GnmExprTop const *texpr,
+				     GnmEvalPos const *pos,
+				     GnmExprEvalFlags flags,
+				     gnm_float *num, gboolean *is_bool,
+				     gboolean *unboxed);
 char	 *gnm_expr_top_as_string  (GnmExprTop const *texpr,
 				   GnmParsePos const *pp,
 				   GnmConventions const *convs);
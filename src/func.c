@@ -29,6 +29,7 @@
 #include "func-builtin.h"
 #include "command-context-stderr.h"
 #include "gnm-plugin.h"
+#include "recalc-profile.h"
 
 #include <goffice/goffice.h>
 #include <glib.h>
@@ -1501,17 +1502,8 @@ free_values (GnmValue **values, int top)
 
 /* ------------------------------------------------------------------------- */
 
-/**
- * function_call_with_exprs:
- * @ei: EvalInfo containing valid fn_def!
- * @flags :
- *
- * Do the guts of calling a function.
- *
- * Returns the result.
- **/
-GnmValue *
-function_call_with_exprs (GnmFuncEvalInfo *ei, GnmExprEvalFlags flags)
+static GnmValue *
+function_call_with_exprs_main (GnmFuncEvalInfo *ei, GnmExprEvalFlags flags)
 {
 	GnmFunc const *fn_def;
 	int	  i, iter_count, iter_width = 0, iter_height = 0;
@@ -1753,6 +1745,29 @@ function_call_with_exprs (GnmFuncEvalInfo *ei, GnmExprEvalFlags flags)
 	return tmp;
 }
 
+/**
+ * function_call_with_exprs:
+ * @ei: EvalInfo containing valid fn_def!
+ * @flags :
+ *
+ * Do the guts of calling a function.
+ *
+ * Returns the result.
+ **/
+GnmValue *
+function_call_with_exprs (GnmFuncEvalInfo *ei, GnmExprEvalFlags flags)
+{
+	GnmValue *res;
+
+	if (!gnm_recalc_profiling)
+		return function_call_with_exprs_main (ei, flags);
+
+	gnm_recalc_profile_enter ();
+	res = function_call_with_exprs_main (ei, flags);
+	gnm_recalc_profile_leave_func (ei->func_call->func);
+	return res;
+}
+
 /*
  * Use this to invoke a register function: the only drawback is that
  * you have to compute/expand all of the values to use this
@@ -0,0 +1,281 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+
+/*
+ * gnm-cell-tiles.c: The cells of a sheet, by position.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+#include <gnumeric-config.h>
+#include "gnumeric.h"
+#include "gnm-cell-tiles.h"
+#include "cell.h"
+
+#include <string.h>
+
+/*
+ * The sheet is cut into square tiles which are kept in a hash keyed on the
+ * tile position, so empty parts of a sheet cost nothing.  Within a tile
+ * each column that has cells gets an array of cell pointers indexed by
+ * row.  Going down a column therefore walks an array, and going along a
+ * row only needs the hash once per tile, see GnmCellTilesBand.
+ *
+ * Column arrays are kept until their tile empties, at which point the
+ * whole tile goes.
+ */
+
+#define TILE_SHIFT	7
+#define TILE_SIZE	(1 << TILE_SHIFT)
+#define TILE_MASK	(TILE_SIZE - 1)
+#define TILE_COL_BITS	12
+
+#define TILE_KEY(col_tile, row_tile) \
+	GUINT_TO_POINTER (((guint)(row_tile) << TILE_COL_BITS) | (guint)(col_tile))
+
+typedef struct {
+	guint	  n_cells;
+	GnmCell **cols[TILE_SIZE];
+} CellTile;
+
+struct _GnmCellTiles {
+	GHashTable *tiles;
+	guint	    n_cells;
+
+	/* Changes whenever a tile is created or freed.  */
+	guint	    stamp;
+};
+
+static void
+cell_tile_free (CellTile *tile)
+{
+	int i;
+	for (i = 0; i < TILE_SIZE; i++)
+		g_free (tile->cols[i]);
+	g_free (tile);
+}
+
+GnmCellTiles *
+gnm_cell_tiles_new (void)
+{
+	GnmCellTiles *tiles = g_new0 (GnmCellTiles, 1);
+	tiles->tiles = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+					      NULL,
+					      (GDestroyNotify)cell_tile_free);
+	return tiles;
+}
+
+/**
+ * gnm_cell_tiles_free :
+ * @tiles :
+ *
+ * Frees the storage but not the cells.
+ **/
+void
+gnm_cell_tiles_free (GnmCellTiles *tiles)
+{
+	if (tiles == NULL)
+		return;
+	g_hash_table_destroy (tiles->tiles);
+	g_free (tiles);
+}
+
+guint
+gnm_cell_tiles_size (GnmCellTiles const *tiles)
+{
+	return tiles->n_cells;
+}
+
+static inline CellTile *
+cell_tiles_lookup (GnmCellTiles const *tiles, int col_tile, int row_tile)
+{
+	return g_hash_table_lookup (tiles->tiles,
+				    TILE_KEY (col_tile, row_tile));
+}
+
+GnmCell *
+gnm_cell_tiles_get (GnmCellTiles const *tiles, int col, int row)
+{
+	CellTile const *tile = cell_tiles_lookup (tiles,
+		col >> TILE_SHIFT, row >> TILE_SHIFT);
+	GnmCell * const *column;
+
+	if (tile == NULL)
+		return NULL;
+	column = tile->cols[col & TILE_MASK];
+	return column ? column[row & TILE_MASK] : NULL;
+}
+
+/**
+ * gnm_cell_tiles_insert :
+ * @tiles :
+ * @cell :
+ *
+ * Stores @cell at its position, replacing whatever was there.
+ **/
+void
+gnm_cell_tiles_insert (GnmCellTiles *tiles, GnmCell *cell)
+{
+	int const col_tile = cell->pos.col >> TILE_SHIFT;
+	int const row_tile = cell->pos.row >> TILE_SHIFT;
+	CellTile *tile;
+	GnmCell **column, **slot;
+
+	g_return_if_fail (col_tile < (1 << TILE_COL_BITS));
+
+	tile = cell_tiles_lookup (tiles, col_tile, row_tile);
+	if (tile == NULL) {
+		tile = g_new0 (CellTile, 1);
+		g_hash_table_insert (tiles->tiles,
+				     TILE_KEY (col_tile, row_tile), tile);
+		tiles->stamp++;
+	}
+
+	column = tile->cols[cell->pos.col & TILE_MASK];
+	if (column == NULL)
+		column = tile->cols[cell->pos.col & TILE_MASK] =
+			g_new0 (GnmCell *, TILE_SIZE);
+
+	slot = column + (cell->pos.row & TILE_MASK);
+	if (*slot == NULL) {
+		tile->n_cells++;
+		tiles->n_cells++;
+	}
+	*slot = cell;
+}
+
+/**
+ * gnm_cell_tiles_remove :
+ * @tiles :
+ * @cell :
+ *
+ * Removes whatever is stored at the position of @cell.
+ **/
+void
+gnm_cell_tiles_remove (GnmCellTiles *tiles, GnmCell *cell)
+{
+	int const col_tile = cell->pos.col >> TILE_SHIFT;
+	int const row_tile = cell->pos.row >> TILE_SHIFT;
+	CellTile *tile = cell_tiles_lookup (tiles, col_tile, row_tile);
+	GnmCell **column, **slot;
+
+	if (tile == NULL)
+		return;
+	column = tile->cols[cell->pos.col & TILE_MASK];
+	if (column == NULL)
+		return;
+	slot = column + (cell->pos.row & TILE_MASK);
+	if (*slot == NULL)
+		return;
+
+	*slot = NULL;
+	tiles->n_cells--;
+	if (--tile->n_cells == 0) {
+		g_hash_table_remove (tiles->tiles,
+				     TILE_KEY (col_tile, row_tile));
+		tiles->stamp++;
+	}
+}
+
+typedef struct {
+	GHFunc	 func;
+	gpointer user;
+} CellTilesForeach;
+
+static void
+cb_tile_foreach (G_GNUC_UNUSED gpointer key, CellTile *tile,
+		 CellTilesForeach *data)
+{
+	int c, r;
+
+	for (c = 0; c < TILE_SIZE; c++) {
+		GnmCell **column = tile->cols[c];
+		if (column == NULL)
+			continue;
+		for (r = 0; r < TILE_SIZE; r++)
+			if (column[r] != NULL)
+				data->func (column[r], column[r], data->user);
+	}
+}
+
+/**
+ * gnm_cell_tiles_foreach :
+ * @tiles :
+ * @func : called with the cell as both key and value, like a GHashTable
+ *	of cells would.
+ * @user :
+ *
+ * Visits the cells in no particular order.  @func must not add or remove
+ * cells, but may free the cell it is given.
+ **/
+void
+gnm_cell_tiles_foreach (GnmCellTiles const *tiles, GHFunc func, gpointer user)
+{
+	CellTilesForeach data;
+
+	data.func = func;
+	data.user = user;
+	g_hash_table_foreach (tiles->tiles, (GHFunc)cb_tile_foreach, &data);
+}
+
+/****************************************************************************/
+
+void
+gnm_cell_tiles_band_init (GnmCellTilesBand *band, GnmCellTiles const *tiles,
+			  int start_col, int end_col)
+{
+	band->tiles = tiles;
+	band->row_tile = -1;
+	band->first = start_col >> TILE_SHIFT;
+	band->last = end_col >> TILE_SHIFT;
+	band->stamp = tiles->stamp;
+	band->tile = g_new0 (gpointer, band->last - band->first + 1);
+}
+
+/**
+ * gnm_cell_tiles_band_get :
+ * @band :
+ * @col : between the columns given to gnm_cell_tiles_band_init
+ * @row :
+ *
+ * Like gnm_cell_tiles_get.
+ **/
+GnmCell *
+gnm_cell_tiles_band_get (GnmCellTilesBand *band, int col, int row)
+{
+	int const row_tile = row >> TILE_SHIFT;
+	CellTile const *tile;
+	GnmCell * const *column;
+
+	if (band->row_tile != row_tile || band->stamp != band->tiles->stamp) {
+		int i;
+		for (i = band->first; i <= band->last; i++)
+			band->tile[i - band->first] =
+				cell_tiles_lookup (band->tiles, i, row_tile);
+		band->row_tile = row_tile;
+		band->stamp = band->tiles->stamp;
+	}
+
+	tile = band->tile[(col >> TILE_SHIFT) - band->first];
+	if (tile == NULL)
+		return NULL;
+	column = tile->cols[col & TILE_MASK];
+	return column ? column[row & TILE_MASK] : NULL;
+}
+
+void
+gnm_cell_tiles_band_clear (GnmCellTilesBand *band)
+{
+	g_free (band->tile);
+	band->tile = NULL;
+}
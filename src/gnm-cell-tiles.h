@@ -0,0 +1,41 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#ifndef _GNM_CELL_TILES_H_
+# define _GNM_CELL_TILES_H_
+
+#include "gnumeric.h"
+
+G_BEGIN_DECLS
+
+GnmCellTiles *gnm_cell_tiles_new	(void);
+void	      gnm_cell_tiles_free	(GnmCellTiles *tiles);
+guint	      gnm_cell_tiles_size	(GnmCellTiles const *tiles);
+
+GnmCell	     *gnm_cell_tiles_get	(GnmCellTiles const *tiles,
+					 int col, int row);
+void	      gnm_cell_tiles_insert	(GnmCellTiles *tiles, GnmCell *cell);
+void	      gnm_cell_tiles_remove	(GnmCellTiles *tiles, GnmCell *cell);
+void	      gnm_cell_tiles_foreach	(GnmCellTiles const *tiles,
+					 GHFunc func, gpointer user);
+
+/*
+ * Looking up a run of cells.  The tiles covering columns @start_col to
+ * @end_col are fetched once per band of rows rather than once per cell.
+ * Cells may be added and removed while a band is in use.
+ */
+typedef struct {
+	GnmCellTiles const *tiles;
+	int	  row_tile;	/* of the fetched tiles, -1 for none */
+	int	  first, last;	/* column tiles covered */
+	guint	  stamp;
+	gpointer *tile;
+} GnmCellTilesBand;
+
+void	 gnm_cell_tiles_band_init  (GnmCellTilesBand *band,
+				    GnmCellTiles const *tiles,
+				    int start_col, int end_col);
+GnmCell *gnm_cell_tiles_band_get   (GnmCellTilesBand *band, int col, int row);
+void	 gnm_cell_tiles_band_clear (GnmCellTilesBand *band);
+
+G_END_DECLS
+
+#endif /* _GNM_CELL_TILES_H_ */
@@ -1231,42 +1231,7 @@ int
 gnm_pane_find_col (GnmPane const *pane, gint64 x, gint64 *col_origin)
 {
 	Sheet const *sheet = scg_sheet (pane->simple.scg);
-	int col   = pane->first.col;
-	gint64 pixel = pane->first_offset.x;
-
-	if (x < pixel) {
-		while (col > 0) {
-			ColRowInfo const *ci = sheet_col_get_info (sheet, --col);
-			if (ci->visible) {
-				pixel -= ci->size_pixels;
-				if (x >= pixel) {
-					if (col_origin)
-						*col_origin = pixel;
-					return col;
-				}
-			}
-		}
-		if (col_origin)
-			*col_origin = 0;
-		return 0;
-	}
-
-	do {
-		ColRowInfo const *ci = sheet_col_get_info (sheet, col);
-		if (ci->visible) {
-			int const tmp = ci->size_pixels;
-			if (x <= pixel + tmp) {
-				if (col_origin)
-					*col_origin = pixel;
-				return col;
-			}
-			pixel += tmp;
-		}
-	} while (++col < gnm_sheet_get_last_col (sheet));
-
-	if (col_origin)
-		*col_origin = pixel;
-	return gnm_sheet_get_last_col (sheet);
+	return colrow_find_pixel (&sheet->cols, x, col_origin);
 }
 
 /**
@@ -1281,41 +1246,7 @@ int
 gnm_pane_find_row (GnmPane const *pane, gint64 y, gint64 *row_origin)
 {
 	Sheet const *sheet = scg_sheet (pane->simple.scg);
-	int row   = pane->first.row;
-	gint64 pixel = pane->first_offset.y;
-
-	if (y < pixel) {
-		while (row > 0) {
-			ColRowInfo const *ri = sheet_row_get_info (sheet, --row);
-			if (ri->visible) {
-				pixel -= ri->size_pixels;
-				if (y >= pixel) {
-					if (row_origin)
-						*row_origin = pixel;
-					return row;
-				}
-			}
-		}
-		if (row_origin)
-			*row_origin = 0;
-		return 0;
-	}
-
-	do {
-		ColRowInfo const *ri = sheet_row_get_info (sheet, row);
-		if (ri->visible) {
-			int const tmp = ri->size_pixels;
-			if (pixel <= y && y <= pixel + tmp) {
-				if (row_origin)
-					*row_origin = pixel;
-				return row;
-			}
-			pixel += tmp;
-		}
-	} while (++row < gnm_sheet_get_last_row (sheet));
-	if (row_origin)
-		*row_origin = pixel;
-	return gnm_sheet_get_last_row (sheet);
+	return colrow_find_pixel (&sheet->rows, y, row_origin);
 }
 
 /*
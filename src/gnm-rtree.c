@@ -0,0 +1,577 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+
+/*
+ * gnm-rtree.c: A spatial index of ranges.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+#include <gnumeric-config.h>
+#include "gnumeric.h"
+#include "gnm-rtree.h"
+#include "ranges.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * The index is a set of static R-trees ("slabs") where slab k holds at
+ * most 2^k entries.  Inserting an entry merges it with all the slabs below
+ * the first empty one, like a binary counter, and packs the result with
+ * Sort-Tile-Recursive bulk loading.  That gives well packed trees with
+ * amortised O(log^2 n) insertion and O(log^2 n + k) queries.
+ *
+ * Removed entries are merely marked as such.  A slab is repacked once more
+ * than half of its entries are gone.
+ *
+ * Within a batch (see gnm_rtree_begin_batch) new entries are kept in an
+ * unsorted list and repacking is put off, so that the whole batch is
+ * packed in one go when it ends.
+ *
+ * Callbacks must not insert into or remove from the tree being traversed.
+ */
+
+#define RTREE_FANOUT	16
+#define RTREE_MAX_SLABS	32
+#define RTREE_PENDING	(RTREE_MAX_SLABS - 1)	/* where-slot of batch entries */
+
+typedef struct {
+	GnmRange  r;		/* Must be first */
+	gpointer  data;		/* NULL once removed */
+} RTreeEntry;
+
+typedef struct {
+	GnmRange  bbox;		/* Must be first */
+	guint	  first, count;
+} RTreeNode;
+
+typedef struct {
+	RTreeEntry *entries;
+	guint	    n_entries, n_removed;
+
+	/* Nodes are stored level by level starting with the leaves and
+	 * ending with the root.  Leaves point into entries, the other
+	 * nodes point into nodes.  */
+	RTreeNode  *nodes;
+	guint	    n_nodes, n_leaves;
+} RTreeSlab;
+
+struct _GnmRTree {
+	RTreeSlab  *slabs[RTREE_MAX_SLABS];
+	guint	    size;
+
+	/* Maps data to the slab and index of its entry.  */
+	GHashTable *where;
+
+	/* Entries inserted during the current batch, not yet packed.  */
+	GArray	   *pending;
+	guint	    batch;
+};
+
+#define WHERE_ENCODE(k,i) GUINT_TO_POINTER ((i) * RTREE_MAX_SLABS + (k) + 1)
+#define WHERE_SLAB(w)	  ((GPOINTER_TO_UINT (w) - 1) % RTREE_MAX_SLABS)
+#define WHERE_INDEX(w)	  ((GPOINTER_TO_UINT (w) - 1) / RTREE_MAX_SLABS)
+
+/* Both RTreeEntry and RTreeNode start with their range.  */
+static int
+cb_range_cmp_col (void const *a_, void const *b_)
+{
+	GnmRange const *a = a_, *b = b_;
+	int ca = a->start.col + a->end.col;
+	int cb = b->start.col + b->end.col;
+	return (ca > cb) - (ca < cb);
+}
+
+static int
+cb_range_cmp_row (void const *a_, void const *b_)
+{
+	GnmRange const *a = a_, *b = b_;
+	int ca = a->start.row + a->end.row;
+	int cb = b->start.row + b->end.row;
+	return (ca > cb) - (ca < cb);
+}
+
+/*
+ * Sort-Tile-Recursive ordering: sort on the column centre, cut into
+ * vertical slices of whole nodes, then sort each slice on the row centre.
+ */
+static void
+str_sort (gpointer base, guint n, gsize size)
+{
+	guint n_groups = (n + RTREE_FANOUT - 1) / RTREE_FANOUT;
+	guint n_slices = 1, slice_len, i;
+
+	while (n_slices * n_slices < n_groups)
+		n_slices++;
+	slice_len = n_slices * RTREE_FANOUT;
+
+	qsort (base, n, size, cb_range_cmp_col);
+	for (i = 0; i < n; i += slice_len)
+		qsort ((char *)base + i * size, MIN (slice_len, n - i),
+		       size, cb_range_cmp_row);
+}
+
+static void
+bbox_union (GnmRange *bbox, GnmRange const *r)
+{
+	if (bbox->start.col > r->start.col) bbox->start.col = r->start.col;
+	if (bbox->start.row > r->start.row) bbox->start.row = r->start.row;
+	if (bbox->end.col < r->end.col) bbox->end.col = r->end.col;
+	if (bbox->end.row < r->end.row) bbox->end.row = r->end.row;
+}
+
+/* Takes ownership of @entries, which must all be live.  */
+static RTreeSlab *
+rtree_slab_new (RTreeEntry *entries, guint n)
+{
+	RTreeSlab *slab = g_new (RTreeSlab, 1);
+	guint i, len, total, level_start, level_len;
+
+	slab->entries = entries;
+	slab->n_entries = n;
+	slab->n_removed = 0;
+
+	total = 0;
+	len = n;
+	do {
+		len = (len + RTREE_FANOUT - 1) / RTREE_FANOUT;
+		total += len;
+	} while (len > 1);
+	slab->nodes = g_new (RTreeNode, total);
+
+	str_sort (entries, n, sizeof (RTreeEntry));
+	slab->n_nodes = 0;
+	for (i = 0; i < n; i += RTREE_FANOUT) {
+		RTreeNode *node = slab->nodes + slab->n_nodes++;
+		guint j;
+
+		node->first = i;
+		node->count = MIN (RTREE_FANOUT, n - i);
+		node->bbox = entries[i].r;
+		for (j = 1; j < node->count; j++)
+			bbox_union (&node->bbox, &entries[i + j].r);
+	}
+	slab->n_leaves = slab->n_nodes;
+
+	level_start = 0;
+	level_len = slab->n_nodes;
+	while (level_len > 1) {
+		str_sort (slab->nodes + level_start, level_len,
+			  sizeof (RTreeNode));
+		for (i = 0; i < level_len; i += RTREE_FANOUT) {
+			RTreeNode *node = slab->nodes + slab->n_nodes++;
+			guint j;
+
+			node->first = level_start + i;
+			node->count = MIN (RTREE_FANOUT, level_len - i);
+			node->bbox = slab->nodes[node->first].bbox;
+			for (j = 1; j < node->count; j++)
+				bbox_union (&node->bbox,
+					    &slab->nodes[node->first + j].bbox);
+		}
+		level_start += level_len;
+		level_len = slab->n_nodes - level_start;
+	}
+
+	g_assert (slab->n_nodes == total);
+	return slab;
+}
+
+static void
+rtree_slab_free (RTreeSlab *slab)
+{
+	g_free (slab->entries);
+	g_free (slab->nodes);
+	g_free (slab);
+}
+
+/* Copy the live entries of @slab to @dst, returns the number copied.  */
+static guint
+rtree_slab_copy_live (RTreeSlab const *slab, RTreeEntry *dst)
+{
+	guint i, n = 0;
+
+	for (i = 0; i < slab->n_entries; i++)
+		if (slab->entries[i].data != NULL)
+			dst[n++] = slab->entries[i];
+	return n;
+}
+
+static void
+rtree_set_slab (GnmRTree *tree, guint k, RTreeSlab *slab)
+{
+	guint i;
+
+	tree->slabs[k] = slab;
+	for (i = 0; i < slab->n_entries; i++)
+		g_hash_table_insert (tree->where, slab->entries[i].data,
+				     WHERE_ENCODE (k, i));
+}
+
+/* Repack slab @k if too many of its entries are gone.  */
+static void
+rtree_slab_maybe_repack (GnmRTree *tree, guint k)
+{
+	RTreeSlab *slab = tree->slabs[k];
+
+	if (slab->n_removed == slab->n_entries) {
+		rtree_slab_free (slab);
+		tree->slabs[k] = NULL;
+	} else if (2 * slab->n_removed > slab->n_entries) {
+		guint n = slab->n_entries - slab->n_removed;
+		RTreeEntry *entries = g_new (RTreeEntry, n);
+
+		rtree_slab_copy_live (slab, entries);
+		rtree_slab_free (slab);
+		rtree_set_slab (tree, k, rtree_slab_new (entries, n));
+	}
+}
+
+/*
+ * Packs the @n entries in @extra, which must all be live, together with
+ * the slabs below the first empty one that can hold the lot.
+ */
+static void
+rtree_merge (GnmRTree *tree, RTreeEntry const *extra, guint n)
+{
+	RTreeEntry *entries;
+	guint k, j, total = n;
+
+	for (k = 0; k < RTREE_PENDING; k++) {
+		RTreeSlab const *slab = tree->slabs[k];
+		if (slab == NULL && total <= (1u << k))
+			break;
+		if (slab != NULL)
+			total += slab->n_entries - slab->n_removed;
+	}
+	g_return_if_fail (k < RTREE_PENDING);
+
+	entries = g_new (RTreeEntry, total);
+	memcpy (entries, extra, n * sizeof (RTreeEntry));
+	for (j = 0; j < k; j++) {
+		if (tree->slabs[j] == NULL)
+			continue;
+		n += rtree_slab_copy_live (tree->slabs[j], entries + n);
+		rtree_slab_free (tree->slabs[j]);
+		tree->slabs[j] = NULL;
+	}
+
+	rtree_set_slab (tree, k, rtree_slab_new (entries, n));
+}
+
+static void
+rtree_pending_foreach_overlapping (GnmRTree const *tree, GnmRange const *r,
+				   GnmRTreeFunc func, gpointer user)
+{
+	guint i;
+
+	for (i = 0; i < tree->pending->len; i++) {
+		RTreeEntry const *e =
+			&g_array_index (tree->pending, RTreeEntry, i);
+		if (e->data != NULL && (r == NULL || range_overlap (&e->r, r)))
+			func (e->data, &e->r, user);
+	}
+}
+
+static void
+rtree_slab_foreach_overlapping (RTreeSlab const *slab, guint ni,
+				GnmRange const *r,
+				GnmRTreeFunc func, gpointer user)
+{
+	RTreeNode const *node = slab->nodes + ni;
+	guint i, end;
+
+	if (!range_overlap (&node->bbox, r))
+		return;
+
+	end = node->first + node->count;
+	if (ni < slab->n_leaves) {
+		for (i = node->first; i < end; i++) {
+			RTreeEntry const *e = slab->entries + i;
+			if (e->data != NULL && range_overlap (&e->r, r))
+				func (e->data, &e->r, user);
+		}
+	} else {
+		for (i = node->first; i < end; i++)
+			rtree_slab_foreach_overlapping (slab, i, r, func, user);
+	}
+}
+
+/**
+ * gnm_rtree_new :
+ *
+ * Returns a new empty spatial index of ranges.
+ **/
+GnmRTree *
+gnm_rtree_new (void)
+{
+	GnmRTree *tree = g_new0 (GnmRTree, 1);
+	tree->where = g_hash_table_new (g_direct_hash, g_direct_equal);
+	return tree;
+}
+
+void
+gnm_rtree_free (GnmRTree *tree)
+{
+	guint k;
+
+	if (tree == NULL)
+		return;
+
+	for (k = 0; k < RTREE_MAX_SLABS; k++)
+		if (tree->slabs[k] != NULL)
+			rtree_slab_free (tree->slabs[k]);
+	if (tree->pending != NULL)
+		g_array_free (tree->pending, TRUE);
+	g_hash_table_destroy (tree->where);
+	g_free (tree);
+}
+
+guint
+gnm_rtree_size (GnmRTree const *tree)
+{
+	g_return_val_if_fail (tree != NULL, 0);
+	return tree->size;
+}
+
+/**
+ * gnm_rtree_get_memory :
+ * @tree : #GnmRTree
+ *
+ * Returns an estimate of the number of bytes used by @tree, not counting
+ * the data.
+ **/
+gsize
+gnm_rtree_get_memory (GnmRTree const *tree)
+{
+	gsize res;
+	guint k;
+
+	g_return_val_if_fail (tree != NULL, 0);
+
+	res = sizeof (GnmRTree) +
+		/* An estimate, GHashTable's layout is private.  */
+		g_hash_table_size (tree->where) * 4 * sizeof (gpointer);
+	for (k = 0; k < RTREE_MAX_SLABS; k++) {
+		RTreeSlab const *slab = tree->slabs[k];
+		if (slab != NULL)
+			res += sizeof (RTreeSlab) +
+				slab->n_entries * sizeof (RTreeEntry) +
+				slab->n_nodes * sizeof (RTreeNode);
+	}
+	if (tree->pending != NULL)
+		res += tree->pending->len * sizeof (RTreeEntry);
+	return res;
+}
+
+/**
+ * gnm_rtree_insert :
+ * @tree : #GnmRTree
+ * @r : the range
+ * @data : non-NULL key to store, must not already be in @tree
+ *
+ * Adds @data covering @r to @tree.  The range is copied.
+ **/
+void
+gnm_rtree_insert (GnmRTree *tree, GnmRange const *r, gpointer data)
+{
+	RTreeEntry e;
+
+	g_return_if_fail (tree != NULL);
+	g_return_if_fail (r != NULL);
+	g_return_if_fail (data != NULL);
+	g_return_if_fail (g_hash_table_lookup (tree->where, data) == NULL);
+
+	e.r = *r;
+	e.data = data;
+	if (tree->batch > 0) {
+		g_array_append_val (tree->pending, e);
+		g_hash_table_insert (tree->where, data,
+			WHERE_ENCODE (RTREE_PENDING, tree->pending->len - 1));
+	} else
+		rtree_merge (tree, &e, 1);
+	tree->size++;
+}
+
+/**
+ * gnm_rtree_remove :
+ * @tree : #GnmRTree
+ * @data : the key
+ *
+ * Returns TRUE if @data was found and removed.
+ **/
+gboolean
+gnm_rtree_remove (GnmRTree *tree, gpointer data)
+{
+	gpointer where;
+	RTreeSlab *slab;
+	guint k;
+
+	g_return_val_if_fail (tree != NULL, FALSE);
+
+	where = g_hash_table_lookup (tree->where, data);
+	if (where == NULL)
+		return FALSE;
+	g_hash_table_remove (tree->where, data);
+
+	tree->size--;
+
+	k = WHERE_SLAB (where);
+	if (k == RTREE_PENDING) {
+		g_array_index (tree->pending, RTreeEntry,
+			       WHERE_INDEX (where)).data = NULL;
+		return TRUE;
+	}
+
+	slab = tree->slabs[k];
+	slab->entries[WHERE_INDEX (where)].data = NULL;
+	slab->n_removed++;
+
+	if (tree->batch == 0)
+		rtree_slab_maybe_repack (tree, k);
+
+	return TRUE;
+}
+
+/**
+ * gnm_rtree_begin_batch :
+ * @tree : #GnmRTree
+ *
+ * Starts a batch of insertions and removals.  Until the matching
+ * gnm_rtree_end_batch new entries are merely queued and no slab is
+ * repacked.  Lookups still see every entry, but scan the queued ones one by
+ * one, so keep them out of large batches.  Batches nest.
+ **/
+void
+gnm_rtree_begin_batch (GnmRTree *tree)
+{
+	g_return_if_fail (tree != NULL);
+
+	if (tree->batch++ == 0 && tree->pending == NULL)
+		tree->pending = g_array_new (FALSE, FALSE,
+					     sizeof (RTreeEntry));
+}
+
+/**
+ * gnm_rtree_end_batch :
+ * @tree : #GnmRTree
+ *
+ * Ends a batch started with gnm_rtree_begin_batch.  Ending the outermost
+ * one packs the queued entries into a single slab and repacks the slabs
+ * that lost too many entries.
+ **/
+void
+gnm_rtree_end_batch (GnmRTree *tree)
+{
+	GArray *pending;
+	guint i, n, k;
+
+	g_return_if_fail (tree != NULL);
+	g_return_if_fail (tree->batch > 0);
+
+	if (--tree->batch > 0)
+		return;
+
+	for (k = 0; k < RTREE_PENDING; k++)
+		if (tree->slabs[k] != NULL)
+			rtree_slab_maybe_repack (tree, k);
+
+	/* Squeeze out the entries removed again within the batch.  */
+	pending = tree->pending;
+	for (i = n = 0; i < pending->len; i++) {
+		RTreeEntry const *e = &g_array_index (pending, RTreeEntry, i);
+		if (e->data != NULL)
+			g_array_index (pending, RTreeEntry, n++) = *e;
+	}
+	if (n > 0)
+		rtree_merge (tree, (RTreeEntry const *)pending->data, n);
+	g_array_set_size (pending, 0);
+}
+
+/**
+ * gnm_rtree_foreach :
+ * @tree : #GnmRTree
+ * @func : #GnmRTreeFunc
+ * @user : closure data
+ *
+ * Calls @func for every entry of @tree in no particular order.
+ **/
+void
+gnm_rtree_foreach (GnmRTree const *tree, GnmRTreeFunc func, gpointer user)
+{
+	guint k, i;
+
+	g_return_if_fail (tree != NULL);
+
+	for (k = 0; k < RTREE_MAX_SLABS; k++) {
+		RTreeSlab const *slab = tree->slabs[k];
+		if (slab == NULL)
+			continue;
+		for (i = 0; i < slab->n_entries; i++)
+			if (slab->entries[i].data != NULL)
+				func (slab->entries[i].data,
+				      &slab->entries[i].r, user);
+	}
+	if (tree->pending != NULL)
+		rtree_pending_foreach_overlapping (tree, NULL, func, user);
+}
+
+/**
+ * gnm_rtree_foreach_overlapping :
+ * @tree : #GnmRTree
+ * @r : #GnmRange
+ * @func : #GnmRTreeFunc
+ * @user : closure data
+ *
+ * Calls @func for every entry of @tree whose range overlaps @r.
+ **/
+void
+gnm_rtree_foreach_overlapping (GnmRTree const *tree, GnmRange const *r,
+			       GnmRTreeFunc func, gpointer user)
+{
+	guint k;
+
+	g_return_if_fail (tree != NULL);
+	g_return_if_fail (r != NULL);
+
+	for (k = 0; k < RTREE_MAX_SLABS; k++) {
+		RTreeSlab const *slab = tree->slabs[k];
+		if (slab != NULL)
+			rtree_slab_foreach_overlapping (slab, slab->n_nodes - 1,
+							r, func, user);
+	}
+	if (tree->pending != NULL)
+		rtree_pending_foreach_overlapping (tree, r, func, user);
+}
+
+/**
+ * gnm_rtree_foreach_containing :
+ * @tree : #GnmRTree
+ * @col :
+ * @row :
+ * @func : #GnmRTreeFunc
+ * @user : closure data
+ *
+ * Calls @func for every entry of @tree whose range contains @col,@row.
+ **/
+void
+gnm_rtree_foreach_containing (GnmRTree const *tree, int col, int row,
+			      GnmRTreeFunc func, gpointer user)
+{
+	GnmRange r;
+
+	r.start.col = r.end.col = col;
+	r.start.row = r.end.row = row;
+	gnm_rtree_foreach_overlapping (tree, &r, func, user);
+}
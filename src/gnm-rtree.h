@@ -0,0 +1,33 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#ifndef _GNM_RTREE_H_
+# define _GNM_RTREE_H_
+
+#include "gnumeric.h"
+
+G_BEGIN_DECLS
+
+typedef void (*GnmRTreeFunc) (gpointer data, GnmRange const *r, gpointer user);
+
+GnmRTree *gnm_rtree_new		(void);
+void	  gnm_rtree_free	(GnmRTree *tree);
+guint	  gnm_rtree_size	(GnmRTree const *tree);
+gsize	  gnm_rtree_get_memory	(GnmRTree const *tree);
+
+void	  gnm_rtree_insert	(GnmRTree *tree, GnmRange const *r,
+				 gpointer data);
+gboolean  gnm_rtree_remove	(GnmRTree *tree, gpointer data);
+void	  gnm_rtree_begin_batch	(GnmRTree *tree);
+void	  gnm_rtree_end_batch	(GnmRTree *tree);
+
+void	  gnm_rtree_foreach	(GnmRTree const *tree,
+				 GnmRTreeFunc func, gpointer user);
+void	  gnm_rtree_foreach_overlapping	(GnmRTree const *tree,
+					 GnmRange const *r,
+					 GnmRTreeFunc func, gpointer user);
+void	  gnm_rtree_foreach_containing	(GnmRTree const *tree,
+					 int col, int row,
+					 GnmRTreeFunc func, gpointer user);
+
+G_END_DECLS
+
+#endif /* _GNM_RTREE_H_ */
@@ -52,6 +52,9 @@ typedef struct _SheetObjectImageableIface SheetObjectImageableIface;
 typedef struct _SheetObjectExportableIface SheetObjectExportableIface;
 
 typedef struct _GnmDepContainer		GnmDepContainer;
+typedef struct _GnmRTree		GnmRTree;
+typedef struct _GnmCellTiles		GnmCellTiles;
+typedef struct _GnmCellLoader		GnmCellLoader;
 typedef struct _GnmDependent		GnmDependent;
 typedef struct _GnmCell			GnmCell;
 typedef struct _GnmComment		GnmComment;
@@ -93,6 +96,7 @@ typedef struct _GnmExprSet		GnmExprSet;
 typedef GnmExpr const *			GnmExprConstPtr;
 
 typedef struct _GnmExprTop		GnmExprTop;
+typedef struct _GnmExprCode		GnmExprCode;
 typedef struct _GnmExprSharer		GnmExprSharer;
 
 typedef struct _GnmExprRelocateInfo	GnmExprRelocateInfo;
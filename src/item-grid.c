@@ -461,11 +461,7 @@ item_grid_draw_region (GocItem const *item, cairo_t *cr, double x_0, double y_0,
 		return TRUE;
 
 	/* Respan all rows that need it.  */
-	for (row = start_row; row <= end_row; row++) {
-		ColRowInfo const *ri = sheet_row_get_info (sheet, row);
-		if (ri->visible && ri->needs_respan)
-			row_calc_spans ((ColRowInfo *)ri, row, sheet);
-	}
+	rows_calc_spans (sheet, start_row, end_row);
 
 	sheet_style_update_grid_color (sheet);
 
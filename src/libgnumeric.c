@@ -54,6 +54,7 @@
 #include "gnm-plugin.h"
 #include "mathfunc.h"
 #include "hlink.h"
+#include "recalc-profile.h"
 #include "wbc-gtk-impl.h"
 #include <goffice/goffice.h>
 
@@ -68,6 +69,7 @@ gboolean initial_workbook_open_complete = FALSE;
 static gboolean param_show_version = FALSE;
 static char *param_lib_dir  = NULL;
 static char *param_data_dir = NULL;
+static int param_recalc_threads = 0;
 
 static GOptionEntry const libspreadsheet_options [] = {
 	/*********************************
@@ -93,6 +95,12 @@ static GOptionEntry const libspreadsheet_options [] = {
 		N_("Adjust the root data directory"),
 		N_("DIR")
 	},
+	{
+		"recalc-threads", 0,
+		0, G_OPTION_ARG_INT, &param_recalc_threads,
+		N_("Use up to N threads for recalculation"),
+		N_("N")
+	},
 
 	/**************************************
 	 * Hidden debugging flags */
@@ -117,6 +125,8 @@ cb_gnm_option_group_post_parse (GOptionContext *context,
 			 GNM_VERSION_FULL, gnm_sys_data_dir (), gnm_sys_lib_dir ());
 		exit (0);
 	}
+	if (param_recalc_threads > 0)
+		gnm_dep_set_recalc_threads (param_recalc_threads);
 	return TRUE;
 }
 
@@ -335,6 +345,7 @@ gnm_shutdown (void)
 	functions_shutdown ();
 
 	gnm_rendered_value_shutdown ();
+	gnm_recalc_profile_shutdown ();
 	dependent_types_shutdown ();
 	clipboard_shutdown ();
 	gnm_sheet_cell_shutdown ();
@@ -1624,6 +1624,7 @@ gnm_print_sheet (WorkbookControl *wbc, Sheet *sheet,
 		g_return_if_fail (!export_dst && wbc);
 
 	doc = GO_DOC (sheet->workbook);
+	workbook_recalc_flush (sheet->workbook);
 
 	print = gtk_print_operation_new ();
 
@@ -0,0 +1,352 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+
+/*
+ * recalc-profile.c: Where does the recalc time go ?
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of version 2 of the GNU General Public
+ * License as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301
+ * USA
+ */
+#include <gnumeric-config.h>
+#include "gnumeric.h"
+#include "recalc-profile.h"
+
+#include "dependent.h"
+#include "expr.h"
+#include "func.h"
+#include "position.h"
+
+#include <string.h>
+
+/*
+ * Every evaluation of a dependent or a function call is a frame on a
+ * stack.  A frame's total time includes the frames it encloses, such as
+ * the precedents evaluated on its behalf; its self time does not.  The
+ * report is sorted on self time.
+ *
+ * Records are keyed on the address of the dependent or function and
+ * describe it as it was when first seen.
+ */
+
+gboolean gnm_recalc_profiling = FALSE;
+
+typedef struct {
+	gdouble start;
+	gdouble child;
+} ProfileFrame;
+
+typedef struct {
+	char	*name;
+	char	*expr;		/* NULL for functions */
+	gulong	 count;
+	gdouble	 total;
+	gdouble	 self;
+} ProfileRecord;
+
+static GTimer	  *profile_timer;
+static GArray	  *profile_stack;
+static GHashTable *profile_deps, *profile_funcs;
+
+static void
+profile_record_free (ProfileRecord *rec)
+{
+	g_free (rec->name);
+	g_free (rec->expr);
+	g_free (rec);
+}
+
+/**
+ * gnm_recalc_profile_set_enabled :
+ * @enabled :
+ *
+ * Start or stop collecting.  Records collected so far are kept until
+ * gnm_recalc_profile_reset.
+ **/
+void
+gnm_recalc_profile_set_enabled (gboolean enabled)
+{
+	if (enabled && profile_timer == NULL) {
+		profile_timer = g_timer_new ();
+		profile_stack = g_array_new (FALSE, FALSE,
+					     sizeof (ProfileFrame));
+		profile_deps = g_hash_table_new_full
+			(g_direct_hash, g_direct_equal,
+			 NULL, (GDestroyNotify)profile_record_free);
+		profile_funcs = g_hash_table_new_full
+			(g_direct_hash, g_direct_equal,
+			 NULL, (GDestroyNotify)profile_record_free);
+	}
+	gnm_recalc_profiling = enabled;
+}
+
+void
+gnm_recalc_profile_reset (void)
+{
+	if (profile_timer == NULL)
+		return;
+	g_hash_table_remove_all (profile_deps);
+	g_hash_table_remove_all (profile_funcs);
+}
+
+void
+gnm_recalc_profile_shutdown (void)
+{
+	gnm_recalc_profiling = FALSE;
+	if (profile_timer == NULL)
+		return;
+	g_timer_destroy (profile_timer);
+	profile_timer = NULL;
+	g_array_free (profile_stack, TRUE);
+	profile_stack = NULL;
+	g_hash_table_destroy (profile_deps);
+	profile_deps = NULL;
+	g_hash_table_destroy (profile_funcs);
+	profile_funcs = NULL;
+}
+
+/**
+ * gnm_recalc_profile_enter :
+ *
+ * Open a frame.  Callers check gnm_recalc_profiling first and must close
+ * the frame with one of the leave functions even if profiling has been
+ * switched off in the mean time.
+ **/
+void
+gnm_recalc_profile_enter (void)
+{
+	ProfileFrame frame;
+
+	g_return_if_fail (profile_timer != NULL);
+
+	frame.start = g_timer_elapsed (profile_timer, NULL);
+	frame.child = 0.;
+	g_array_append_val (profile_stack, frame);
+}
+
+static void
+profile_leave (GHashTable *records, gconstpointer key,
+	       char *(*describe) (gconstpointer key, char **expr))
+{
+	ProfileFrame *frame;
+	ProfileRecord *rec;
+	gdouble elapsed;
+
+	g_return_if_fail (profile_stack != NULL && profile_stack->len > 0);
+
+	frame = &g_array_index (profile_stack, ProfileFrame,
+				profile_stack->len - 1);
+	elapsed = g_timer_elapsed (profile_timer, NULL) - frame->start;
+
+	rec = g_hash_table_lookup (records, key);
+	if (rec == NULL) {
+		rec = g_new0 (ProfileRecord, 1);
+		rec->name = describe (key, &rec->expr);
+		g_hash_table_insert (records, (gpointer)key, rec);
+	}
+	rec->count++;
+	rec->total += elapsed;
+	rec->self += elapsed - frame->child;
+
+	g_array_set_size (profile_stack, profile_stack->len - 1);
+	if (profile_stack->len > 0)
+		g_array_index (profile_stack, ProfileFrame,
+			       profile_stack->len - 1).child += elapsed;
+}
+
+static char *
+describe_dep (gconstpointer key, char **expr)
+{
+	GnmDependent const *dep = key;
+	GString *name = g_string_new (NULL);
+
+	dependent_debug_name (dep, name);
+	if (dep->texpr != NULL) {
+		GnmParsePos pp;
+		*expr = gnm_expr_top_as_string (dep->texpr,
+			parse_pos_init_dep (&pp, dep), NULL);
+	}
+	return g_string_free (name, FALSE);
+}
+
+static char *
+describe_func (gconstpointer key, G_GNUC_UNUSED char **expr)
+{
+	return g_strdup (gnm_func_get_name (key, FALSE));
+}
+
+void
+gnm_recalc_profile_leave_dep (GnmDependent const *dep)
+{
+	profile_leave (profile_deps, dep, describe_dep);
+}
+
+void
+gnm_recalc_profile_leave_func (GnmFunc const *func)
+{
+	profile_leave (profile_funcs, func, describe_func);
+}
+
+/****************************************************************************/
+
+static void
+cb_collect (G_GNUC_UNUSED gpointer key, ProfileRecord *rec, GPtrArray *accum)
+{
+	g_ptr_array_add (accum, rec);
+}
+
+static int
+cb_by_self_time (ProfileRecord const **a, ProfileRecord const **b)
+{
+	if ((*a)->self != (*b)->self)
+		return ((*a)->self > (*b)->self) ? -1 : 1;
+	return strcmp ((*a)->name, (*b)->name);
+}
+
+static void
+append_seconds (GString *out, gdouble t)
+{
+	char buf[G_ASCII_DTOSTR_BUF_SIZE];
+	g_string_append (out, g_ascii_formatd (buf, sizeof (buf), "%.6f", t));
+}
+
+static void
+append_csv_string (GString *out, char const *s)
+{
+	if (s == NULL)
+		return;
+	if (strpbrk (s, ",\"\n") == NULL) {
+		g_string_append (out, s);
+		return;
+	}
+	g_string_append_c (out, '"');
+	for (; *s; s++) {
+		if (*s == '"')
+			g_string_append_c (out, '"');
+		g_string_append_c (out, *s);
+	}
+	g_string_append_c (out, '"');
+}
+
+static void
+append_json_string (GString *out, char const *s)
+{
+	if (s == NULL) {
+		g_string_append (out, "null");
+		return;
+	}
+	g_string_append_c (out, '"');
+	for (; *s; s++) {
+		switch (*s) {
+		case '"':  g_string_append (out, "\\\""); break;
+		case '\\': g_string_append (out, "\\\\"); break;
+		case '\n': g_string_append (out, "\\n"); break;
+		case '\t': g_string_append (out, "\\t"); break;
+		default:
+			if ((guchar)*s < 0x20)
+				g_string_append_printf (out, "\\u%04x", *s);
+			else
+				g_string_append_c (out, *s);
+		}
+	}
+	g_string_append_c (out, '"');
+}
+
+static void
+write_csv (GString *out, GPtrArray *recs, char const *kind)
+{
+	unsigned i;
+
+	for (i = 0; i < recs->len; i++) {
+		ProfileRecord const *rec = g_ptr_array_index (recs, i);
+		g_string_append_printf (out, "%s,", kind);
+		append_csv_string (out, rec->name);
+		g_string_append_c (out, ',');
+		append_csv_string (out, rec->expr);
+		g_string_append_printf (out, ",%lu,", rec->count);
+		append_seconds (out, rec->total);
+		g_string_append_c (out, ',');
+		append_seconds (out, rec->self);
+		g_string_append_c (out, '\n');
+	}
+}
+
+static void
+write_json (GString *out, GPtrArray *recs, gboolean with_expr)
+{
+	unsigned i;
+
+	g_string_append (out, "[");
+	for (i = 0; i < recs->len; i++) {
+		ProfileRecord const *rec = g_ptr_array_index (recs, i);
+		g_string_append (out, i ? ",\n    { \"name\": " : "\n    { \"name\": ");
+		append_json_string (out, rec->name);
+		if (with_expr) {
+			g_string_append (out, ", \"expr\": ");
+			append_json_string (out, rec->expr);
+		}
+		g_string_append_printf (out, ", \"count\": %lu, \"total\": ",
+					rec->count);
+		append_seconds (out, rec->total);
+		g_string_append (out, ", \"self\": ");
+		append_seconds (out, rec->self);
+		g_string_append (out, " }");
+	}
+	g_string_append (out, "\n  ]");
+}
+
+static GPtrArray *
+sorted_records (GHashTable *records)
+{
+	GPtrArray *res = g_ptr_array_new ();
+	if (records != NULL)
+		g_hash_table_foreach (records, (GHFunc)cb_collect, res);
+	g_ptr_array_sort (res, (GCompareFunc)cb_by_self_time);
+	return res;
+}
+
+/**
+ * gnm_recalc_profile_save :
+ * @filename : local file name
+ * @err :
+ *
+ * Writes the records collected so far, most expensive first.  Files whose
+ * name ends in ".json" get JSON, anything else gets CSV.  Times are in
+ * seconds.
+ **/
+gboolean
+gnm_recalc_profile_save (char const *filename, GError **err)
+{
+	GPtrArray *deps = sorted_records (profile_deps);
+	GPtrArray *funcs = sorted_records (profile_funcs);
+	GString *out = g_string_new (NULL);
+	gboolean res;
+
+	if (g_str_has_suffix (filename, ".json")) {
+		g_string_append (out, "{\n  \"dependents\": ");
+		write_json (out, deps, TRUE);
+		g_string_append (out, ",\n  \"functions\": ");
+		write_json (out, funcs, FALSE);
+		g_string_append (out, "\n}\n");
+	} else {
+		g_string_append (out, "kind,name,expr,count,total,self\n");
+		write_csv (out, deps, "dependent");
+		write_csv (out, funcs, "function");
+	}
+
+	res = g_file_set_contents (filename, out->str, out->len, err);
+
+	g_string_free (out, TRUE);
+	g_ptr_array_free (funcs, TRUE);
+	g_ptr_array_free (deps, TRUE);
+	return res;
+}
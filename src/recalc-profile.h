@@ -0,0 +1,24 @@
+/* vim: set sw=8: -*- Mode: C; tab-width: 8; indent-tabs-mode: t; c-basic-offset: 8 -*- */
+#ifndef _GNM_RECALC_PROFILE_H_
+# define _GNM_RECALC_PROFILE_H_
+
+#include "gnumeric.h"
+
+G_BEGIN_DECLS
+
+/* Read directly by the evaluation hooks, use the setter to change it.  */
+extern gboolean gnm_recalc_profiling;
+
+void	 gnm_recalc_profile_set_enabled	(gboolean enabled);
+void	 gnm_recalc_profile_reset	(void);
+void	 gnm_recalc_profile_shutdown	(void);
+
+void	 gnm_recalc_profile_enter	(void);
+void	 gnm_recalc_profile_leave_dep	(GnmDependent const *dep);
+void	 gnm_recalc_profile_leave_func	(GnmFunc const *func);
+
+gboolean gnm_recalc_profile_save	(char const *filename, GError **err);
+
+G_END_DECLS
+
+#endif /* _GNM_RECALC_PROFILE_H_ */
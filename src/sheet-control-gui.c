@@ -3034,56 +3034,18 @@ scg_colrow_distance_get (SheetControlGUI const *scg, gboolean is_cols,
 			 int from, int to)
 {
 	Sheet *sheet = scg_sheet (scg);
-	ColRowCollection const *collection;
-	int default_size;
-	int i;
-	gint64 pixels = 0;
-	int sign = 1;
+	int max;
 
 	g_return_val_if_fail (IS_SHEET_CONTROL_GUI (scg), 1);
 
-	if (from > to) {
-		int const tmp = to;
-		to = from;
-		from = tmp;
-		sign = -1;
-	}
-
-	g_return_val_if_fail (from >= 0, 1);
-
-	if (is_cols) {
-		g_return_val_if_fail (to <= gnm_sheet_get_max_cols (sheet), 1);
-		collection = &sheet->cols;
-	} else {
-		g_return_val_if_fail (to <= gnm_sheet_get_max_rows (sheet), 1);
-		collection = &sheet->rows;
-	}
-
-	/* Do not use col_row_foreach, it ignores empties.
-	 * Optimize this so that long jumps are not quite so horrific
-	 * for performance.
-	 */
-	default_size = collection->default_style.size_pixels;
-	for (i = from ; i < to ; ++i) {
-		ColRowSegment const *segment =
-			COLROW_GET_SEGMENT(collection, i);
-
-		if (segment != NULL) {
-			ColRowInfo const *cri = segment->info[COLROW_SUB_INDEX (i)];
-			if (cri == NULL)
-				pixels += default_size;
-			else if (cri->visible)
-				pixels += cri->size_pixels;
-		} else {
-			int segment_end = COLROW_SEGMENT_END (i)+1;
-			if (segment_end > to)
-				segment_end = to;
-			pixels += default_size * (segment_end - i);
-			i = segment_end - 1;
-		}
-	}
+	max = is_cols
+		? gnm_sheet_get_max_cols (sheet)
+		: gnm_sheet_get_max_rows (sheet);
+	g_return_val_if_fail (from >= 0 && to >= 0, 1);
+	g_return_val_if_fail (from <= max && to <= max, 1);
 
-	return pixels*sign;
+	return colrow_get_distance_pixels (is_cols ? &sheet->cols : &sheet->rows,
+					   from, to);
 }
 
 /*************************************************************************/
@@ -35,6 +35,7 @@
 #include "mstyle.h"
 #include "expr.h"
 #include "command-context.h"
+#include "gnm-rtree.h"
 
 static gint
 range_row_cmp (GnmRange const *a, GnmRange const *b)
@@ -45,6 +46,13 @@ range_row_cmp (GnmRange const *a, GnmRange const *b)
 	return tmp;
 }
 
+/* Top to bottom then RIGHT TO LEFT, the reverse of list_merged.  */
+static gint
+range_row_cmp_rev (GnmRange const *a, GnmRange const *b)
+{
+	return range_row_cmp (b, a);
+}
+
 /**
  * gnm_sheet_merge_add :
  *
@@ -114,6 +122,7 @@ gnm_sheet_merge_add (Sheet *sheet, GnmRange const *r, gboolean clear,
 
 	r_copy = gnm_range_dup (r);
 	g_hash_table_insert (sheet->hash_merged, &r_copy->start, r_copy);
+	gnm_rtree_insert (sheet->tree_merged, r_copy, r_copy);
 
 	/* Store in order from bottom to top then LEFT TO RIGHT (by start coord) */
 	sheet->list_merged = g_slist_insert_sorted (sheet->list_merged, r_copy,
@@ -177,6 +186,7 @@ gnm_sheet_merge_remove (Sheet *sheet, GnmRange const *r, GOCmdContext *cc)
 	g_return_val_if_fail (range_equal (r, r_copy), TRUE);
 
 	g_hash_table_remove (sheet->hash_merged, &r_copy->start);
+	gnm_rtree_remove (sheet->tree_merged, r_copy);
 	sheet->list_merged = g_slist_remove (sheet->list_merged, r_copy);
 
 	cell = sheet_cell_get (sheet, r->start.col, r->start.row);
@@ -194,6 +204,13 @@ gnm_sheet_merge_remove (Sheet *sheet, GnmRange const *r, GOCmdContext *cc)
 	return FALSE;
 }
 
+static void
+cb_collect_merge (GnmRange *r, G_GNUC_UNUSED GnmRange const *bound,
+		  GSList **res)
+{
+	*res = g_slist_prepend (*res, r);
+}
+
 /**
  * gnm_sheet_merge_get_overlap :
  *
@@ -204,19 +221,22 @@ gnm_sheet_merge_remove (Sheet *sheet, GnmRange const *r, GOCmdContext *cc)
 GSList *
 gnm_sheet_merge_get_overlap (Sheet const *sheet, GnmRange const *range)
 {
-	GSList *ptr, *res = NULL;
+	GSList *res = NULL;
 
 	g_return_val_if_fail (IS_SHEET (sheet), NULL);
 	g_return_val_if_fail (range != NULL, NULL);
 
-	for (ptr = sheet->list_merged ; ptr != NULL ; ptr = ptr->next) {
-		GnmRange * const test = ptr->data;
+	gnm_rtree_foreach_overlapping (sheet->tree_merged, range,
+		(GnmRTreeFunc)cb_collect_merge, &res);
 
-		if (range_overlap (range, test))
-			res = g_slist_prepend (res, test);
-	}
+	return g_slist_sort (res, (GCompareFunc)range_row_cmp_rev);
+}
 
-	return res;
+static void
+cb_find_merge (GnmRange const *r, G_GNUC_UNUSED GnmRange const *bound,
+	       GnmRange const **res)
+{
+	*res = r;
 }
 
 /**
@@ -228,17 +248,37 @@ gnm_sheet_merge_get_overlap (Sheet const *sheet, GnmRange const *range)
 GnmRange const *
 gnm_sheet_merge_contains_pos (Sheet const *sheet, GnmCellPos const *pos)
 {
-	GSList *ptr;
+	GnmRange const *res = NULL;
 
 	g_return_val_if_fail (IS_SHEET (sheet), NULL);
 	g_return_val_if_fail (pos != NULL, NULL);
 
-	for (ptr = sheet->list_merged ; ptr != NULL ; ptr = ptr->next) {
-		GnmRange const * const range = ptr->data;
-		if (range_contains (range, pos->col, pos->row))
-			return range;
+	/* Merged regions do not overlap, so there is at most one.  */
+	gnm_rtree_foreach_containing (sheet->tree_merged, pos->col, pos->row,
+		(GnmRTreeFunc)cb_find_merge, &res);
+	return res;
+}
+
+typedef struct {
+	GnmCellPos const *pos;
+	GnmRange const *left, *right;
+} MergeAdjacent;
+
+static void
+cb_merge_adjacent (GnmRange const *test, G_GNUC_UNUSED GnmRange const *bound,
+		   MergeAdjacent *closure)
+{
+	int const diff = test->end.col - closure->pos->col;
+
+	g_return_if_fail (diff != 0);
+
+	if (diff < 0) {
+		if (closure->left == NULL || closure->left->end.col < test->end.col)
+			closure->left = test;
+	} else {
+		if (closure->right == NULL || closure->right->start.col > test->start.col)
+			closure->right = test;
 	}
-	return NULL;
 }
 
 /**
@@ -254,28 +294,19 @@ void
 gnm_sheet_merge_get_adjacent (Sheet const *sheet, GnmCellPos const *pos,
 			      GnmRange const **left, GnmRange const **right)
 {
-	GSList *ptr;
+	MergeAdjacent closure;
+	GnmRange row;
 
 	g_return_if_fail (IS_SHEET (sheet));
 	g_return_if_fail (pos != NULL);
 
-	*left = *right = NULL;
-	for (ptr = sheet->list_merged ; ptr != NULL ; ptr = ptr->next) {
-		GnmRange const * const test = ptr->data;
-		if (test->start.row <= pos->row && pos->row <= test->end.row) {
-			int const diff = test->end.col - pos->col;
-
-			g_return_if_fail (diff != 0);
-
-			if (diff < 0) {
-				if (*left == NULL || (*left)->end.col < test->end.col)
-					*left = test;
-			} else {
-				if (*right == NULL || (*right)->start.col > test->start.col)
-					*right = test;
-			}
-		}
-	}
+	closure.pos = pos;
+	closure.left = closure.right = NULL;
+	range_init_rows (&row, sheet, pos->row, pos->row);
+	gnm_rtree_foreach_overlapping (sheet->tree_merged, &row,
+		(GnmRTreeFunc)cb_merge_adjacent, &closure);
+	*left = closure.left;
+	*right = closure.right;
 }
 
 /**
@@ -39,6 +39,7 @@
 #include <goffice/goffice.h>
 #include "application.h"
 #include "gutils.h"
+#include "gnm-rtree.h"
 
 #include <libxml/globals.h>
 #include <gsf/gsf-impl-utils.h>
@@ -243,6 +244,14 @@ sheet_objects_max_extent (Sheet *sheet)
 	}
 }
 
+/* Call after changing the cell_bound of an object that is in a sheet.  */
+static void
+sheet_object_reindex (SheetObject *so)
+{
+	gnm_rtree_remove (so->sheet->object_index, so);
+	gnm_rtree_insert (so->sheet->object_index, &so->anchor.cell_bound, so);
+}
+
 void
 sheet_object_set_name (SheetObject *so, const char *name)
 {
@@ -470,7 +479,6 @@ sheet_object_set_sheet (SheetObject *so, Sheet *sheet)
 		return FALSE;
 
 	g_return_val_if_fail (so->sheet == NULL, TRUE);
-	g_return_val_if_fail (g_slist_find (sheet->sheet_objects, so) == NULL, TRUE);
 
 	so->sheet = sheet;
 	if (SO_CLASS (so)->assign_to_sheet &&
@@ -481,8 +489,17 @@ sheet_object_set_sheet (SheetObject *so, Sheet *sheet)
 
 	g_object_ref (G_OBJECT (so));
 	sheet->sheet_objects = g_slist_prepend (sheet->sheet_objects, so);
-	/* FIXME : add a flag to sheet to have sheet_update do this */
-	sheet_objects_max_extent (sheet);
+	gnm_rtree_insert (sheet->object_index, &so->anchor.cell_bound, so);
+
+	/* Adding an object can only grow the extent.  */
+	if (sheet->max_object_extent.col < so->anchor.cell_bound.end.col ||
+	    sheet->max_object_extent.row < so->anchor.cell_bound.end.row) {
+		sheet->max_object_extent.col = MAX (sheet->max_object_extent.col,
+						    so->anchor.cell_bound.end.col);
+		sheet->max_object_extent.row = MAX (sheet->max_object_extent.row,
+						    so->anchor.cell_bound.end.row);
+		sheet_scrollbar_config (sheet);
+	}
 
 	if (NULL == g_object_get_data (G_OBJECT (so), "create_view_handler")) {
 		guint id = g_idle_add ((GSourceFunc) cb_create_views, so);
@@ -536,6 +553,7 @@ sheet_object_clear_sheet (SheetObject *so)
 
 	so->sheet->sheet_objects = g_slist_remove_link (so->sheet->sheet_objects, ptr);
 	g_slist_free (ptr);
+	gnm_rtree_remove (so->sheet->object_index, so);
 
 	if (so->anchor.cell_bound.end.col == so->sheet->max_object_extent.col &&
 	    so->anchor.cell_bound.end.row == so->sheet->max_object_extent.row)
@@ -726,6 +744,7 @@ sheet_object_set_anchor (SheetObject *so, SheetObjectAnchor const *anchor)
 
 	so->anchor = *anchor;
 	if (so->sheet != NULL) {
+		sheet_object_reindex (so);
 		sheet_objects_max_extent (so->sheet);
 		sheet_object_update_bounds (so, NULL);
 	}
@@ -903,6 +922,7 @@ sheet_objects_relocate (GnmExprRelocateInfo const *rinfo, gboolean update,
 				continue;
 			}
 			so->anchor.cell_bound = r;
+			sheet_object_reindex (so);
 
 			if (change_sheets) {
 				g_object_ref (so);
@@ -934,24 +954,64 @@ sheet_objects_relocate (GnmExprRelocateInfo const *rinfo, gboolean update,
  * Containing all objects of exactly the specified type (inheritence does not count)
  * that are completely contained by @r.
  **/
+typedef struct {
+	GnmRange const *r;
+	GType t;
+	GHashTable *found;
+	SheetObject *last;
+} SheetObjectsGet;
+
+static void
+cb_sheet_objects_get (SheetObject *so, G_GNUC_UNUSED GnmRange const *bound,
+		      SheetObjectsGet *closure)
+{
+	if ((closure->t == G_TYPE_NONE || closure->t == G_OBJECT_TYPE (so)) &&
+	    range_contained (&so->anchor.cell_bound, closure->r)) {
+		g_hash_table_insert (closure->found, so, so);
+		closure->last = so;
+	}
+}
+
 GSList *
 sheet_objects_get (Sheet const *sheet, GnmRange const *r, GType t)
 {
 	GSList *res = NULL;
 	GSList *ptr;
+	SheetObjectsGet closure;
 
 	g_return_val_if_fail (IS_SHEET (sheet), NULL);
 
-	for (ptr = sheet->sheet_objects; ptr != NULL ; ptr = ptr->next ) {
-		GObject *obj = G_OBJECT (ptr->data);
-
-		if (t == G_TYPE_NONE || t == G_OBJECT_TYPE (obj)) {
-			SheetObject *so = SHEET_OBJECT (obj);
-			if (r == NULL || range_contained (&so->anchor.cell_bound, r))
-				res = g_slist_prepend (res, so);
+	if (r == NULL) {
+		for (ptr = sheet->sheet_objects; ptr != NULL ; ptr = ptr->next ) {
+			GObject *obj = G_OBJECT (ptr->data);
+			if (t == G_TYPE_NONE || t == G_OBJECT_TYPE (obj))
+				res = g_slist_prepend (res, obj);
 		}
+		return g_slist_reverse (res);
+	}
+
+	closure.r = r;
+	closure.t = t;
+	closure.found = g_hash_table_new (g_direct_hash, g_direct_equal);
+	closure.last = NULL;
+	gnm_rtree_foreach_overlapping (sheet->object_index, r,
+		(GnmRTreeFunc)cb_sheet_objects_get, &closure);
+
+	switch (g_hash_table_size (closure.found)) {
+	case 0:
+		break;
+	case 1:
+		res = g_slist_prepend (NULL, closure.last);
+		break;
+	default:
+		/* Keep the stacking order of sheet_objects.  */
+		for (ptr = sheet->sheet_objects; ptr != NULL ; ptr = ptr->next )
+			if (g_hash_table_lookup (closure.found, ptr->data))
+				res = g_slist_prepend (res, ptr->data);
+		res = g_slist_reverse (res);
 	}
-	return g_slist_reverse (res);
+	g_hash_table_destroy (closure.found);
+	return res;
 }
 
 /**
@@ -966,19 +1026,19 @@ void
 sheet_objects_clear (Sheet const *sheet, GnmRange const *r, GType t,
 		     GOUndo **pundo)
 {
-	GSList *ptr, *next;
+	GSList *ptr, *objs;
 
 	g_return_if_fail (IS_SHEET (sheet));
 
-	for (ptr = sheet->sheet_objects; ptr != NULL ; ptr = next ) {
-		GObject *obj = G_OBJECT (ptr->data);
-		next = ptr->next;
-		if (t == G_TYPE_NONE || t == G_OBJECT_TYPE (obj)) {
-			SheetObject *so = SHEET_OBJECT (obj);
-			if (r == NULL || range_contained (&so->anchor.cell_bound, r))
-				clear_sheet (so, pundo);
-		}
+	/* Hold on to them in case clearing one takes others along.  */
+	objs = sheet_objects_get (sheet, r, t);
+	g_slist_foreach (objs, (GFunc)g_object_ref, NULL);
+	for (ptr = objs; ptr != NULL ; ptr = ptr->next) {
+		SheetObject *so = SHEET_OBJECT (ptr->data);
+		if (so->sheet == sheet)
+			clear_sheet (so, pundo);
 	}
+	go_slist_free_custom (objs, g_object_unref);
 }
 
 /**
@@ -611,6 +611,68 @@ sheet_style_resize (Sheet *sheet, int cols, int rows)
 	style_list_free	(styles);
 }
 
+static CellTile *
+cell_tile_dup (CellTile const *src, Sheet *dst, GHashTable *map)
+{
+	CellTileType const t = src->type;
+	CellTile *res;
+	int i;
+
+	if (t == TILE_PTR_MATRIX) {
+		res = (CellTile *)CHUNK_ALLOC (CellTilePtrMatrix,
+					       tile_pools[TILE_PTR_MATRIX]);
+		*((CellTileType *)&(res->type)) = TILE_PTR_MATRIX;
+		for (i = 0; i < TILE_SIZE_COL * TILE_SIZE_ROW; i++)
+			res->ptr_matrix.ptr[i] =
+				cell_tile_dup (src->ptr_matrix.ptr[i], dst, map);
+		return res;
+	}
+
+	res = cell_tile_style_new (NULL, t);
+	for (i = 0; i < tile_size[t]; i++) {
+		GnmStyle *style = src->style_any.style[i];
+		GnmStyle *dst_style = g_hash_table_lookup (map, style);
+
+		/* Each distinct style is linked into @dst once, and each
+		 * use after that only adds a link.  */
+		if (dst_style == NULL) {
+			gnm_style_ref (style);
+			dst_style = sheet_style_find (dst, style);
+			g_hash_table_insert (map, style, dst_style);
+		} else
+			gnm_style_link (dst_style);
+		res->style_any.style[i] = dst_style;
+	}
+	return res;
+}
+
+/**
+ * sheet_style_dup :
+ * @src : #Sheet
+ * @dst : #Sheet of the same size, with default styles
+ *
+ * Gives @dst the styles of @src by copying the tile structure rather than
+ * applying the styles region by region.
+ **/
+void
+sheet_style_dup (Sheet const *src, Sheet *dst)
+{
+	GHashTable *map;
+
+	g_return_if_fail (IS_SHEET (src));
+	g_return_if_fail (IS_SHEET (dst));
+	g_return_if_fail (src->tile_top_level == dst->tile_top_level);
+
+	sheet_style_set_auto_pattern_color (dst,
+		sheet_style_get_auto_pattern_color (src));
+
+	map = g_hash_table_new (g_direct_hash, g_direct_equal);
+	cell_tile_dtor (dst->style_data->styles);
+	dst->style_data->styles =
+		cell_tile_dup (src->style_data->styles, dst, map);
+	g_hash_table_destroy (map);
+}
+
 static gboolean
 cb_unlink (void *key, void *value, void *user)
 {
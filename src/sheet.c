@@ -48,6 +48,8 @@
 #include "cellspan.h"
 #include "cell.h"
 #include "sheet-merge.h"
+#include "gnm-cell-tiles.h"
+#include "gnm-rtree.h"
 #include "sheet-private.h"
 #include "expr-name.h"
 #include "expr.h"
@@ -344,6 +346,7 @@ sheet_scale_changed (Sheet *sheet, gboolean cols_rescaled, gboolean rows_rescale
 						sheet, TRUE, closure.scale);
 		colrow_foreach (&sheet->cols, 0, gnm_sheet_get_last_col (sheet),
 			(ColRowHandler)&cb_colrow_compute_pixels_from_pts, &closure);
+		colrow_sizes_changed (&sheet->cols, 0);
 	}
 	if (rows_rescaled) {
 		struct resize_colrow closure;
@@ -356,6 +359,7 @@ sheet_scale_changed (Sheet *sheet, gboolean cols_rescaled, gboolean rows_rescale
 						sheet, FALSE, closure.scale);
 		colrow_foreach (&sheet->rows, 0, gnm_sheet_get_last_row (sheet),
 			(ColRowHandler)&cb_colrow_compute_pixels_from_pts, &closure);
+		colrow_sizes_changed (&sheet->rows, 0);
 	}
 
 	sheet_cell_foreach (sheet, (GHFunc)&cb_clear_rendered_cells, NULL);
@@ -706,21 +710,6 @@ gnm_sheet_constructed (GObject *obj)
 		parent_class->constructed (obj);
 }
 
-static guint
-cell_set_hash (GnmCell const *key)
-{
-	guint h = key->pos.row;
-	h = (h << 16) ^ (h >> 16);
-	h ^= key->pos.col;
-	return h;
-}
-
-static gint
-cell_set_equal (GnmCell const *a, GnmCell const *b)
-{
-	return (a->pos.row == b->pos.row && a->pos.col == b->pos.col);
-}
-
 static void
 gnm_sheet_init (Sheet *sheet)
 {
@@ -765,6 +754,7 @@ gnm_sheet_init (Sheet *sheet)
 #endif
 
 	sheet->sheet_objects = NULL;
+	sheet->object_index = gnm_rtree_new ();
 	sheet->max_object_extent.col = sheet->max_object_extent.row = 0;
 
 	sheet->solver_parameters = gnm_solver_param_new (sheet);
@@ -785,9 +775,9 @@ gnm_sheet_init (Sheet *sheet)
 	sheet->list_merged = NULL;
 	sheet->hash_merged = g_hash_table_new ((GHashFunc)&gnm_cellpos_hash,
 					       (GCompareFunc)&gnm_cellpos_equal);
+	sheet->tree_merged = gnm_rtree_new ();
 
-	sheet->cell_hash = g_hash_table_new ((GHashFunc)&cell_set_hash,
-					     (GCompareFunc)&cell_set_equal);
+	sheet->cell_tiles = gnm_cell_tiles_new ();
 
 	/* Init preferences */
 	sheet->convs = gnm_conventions_default;
@@ -1218,7 +1208,7 @@ gnm_sheet_resize_main (Sheet *sheet, int cols, int rows,
 	{
 		GSList *l, *linked = NULL;
 		/* FIXME: what about dependents in other workbooks?  */
-		WORKBOOK_FOREACH_DEPENDENT
+		WORKBOOK_FOREACH_DEPENDENT_SAFE
 			(sheet->workbook, dep,
 
 			 if (dependent_is_linked (dep)) {
@@ -1226,7 +1216,7 @@ gnm_sheet_resize_main (Sheet *sheet, int cols, int rows,
 				 linked = g_slist_prepend (linked, dep);
 			 });
 
-		gnm_dep_container_resize (sheet->deps, rows);
+		gnm_dep_container_resize (sheet->deps, cols, rows);
 
 		for (l = linked; l; l = l->next) {
 			GnmDependent *dep = l->data;
@@ -1641,6 +1631,7 @@ sheet_col_add (Sheet *sheet, ColRowInfo *cp, int col)
 	if (*segment == NULL)
 		*segment = g_new0 (ColRowSegment, 1);
 	(*segment)->info[COLROW_SUB_INDEX (col)] = cp;
+	colrow_sizes_changed (&sheet->cols, col);
 
 	if (cp->outline_level > sheet->cols.max_outline_level)
 		sheet->cols.max_outline_level = cp->outline_level;
@@ -1661,6 +1652,7 @@ sheet_row_add (Sheet *sheet, ColRowInfo *rp, int row)
 	if (*segment == NULL)
 		*segment = g_new0 (ColRowSegment, 1);
 	(*segment)->info[COLROW_SUB_INDEX (row)] = rp;
+	colrow_sizes_changed (&sheet->rows, row);
 
 	if (rp->outline_level > sheet->rows.max_outline_level)
 		sheet->rows.max_outline_level = rp->outline_level;
@@ -1670,12 +1662,49 @@ sheet_row_add (Sheet *sheet, ColRowInfo *rp, int row)
 	}
 }
 
+typedef struct {
+	GnmCellPos const *pos;	/* NULL for the column query */
+	GSList *objs;
+} RepositionObjects;
+
+static void
+cb_collect_moved_object (SheetObject *so, G_GNUC_UNUSED GnmRange const *bound,
+			 RepositionObjects *closure)
+{
+	/* Already found by the column query.  */
+	if (closure->pos != NULL &&
+	    so->anchor.cell_bound.end.col >= closure->pos->col)
+		return;
+	closure->objs = g_slist_prepend (closure->objs, so);
+}
+
 static void
 sheet_reposition_objects (Sheet const *sheet, GnmCellPos const *pos)
 {
+	RepositionObjects closure;
 	GSList *ptr;
-	for (ptr = sheet->sheet_objects; ptr != NULL ; ptr = ptr->next )
+	GnmRange r;
+
+	/* Only objects ending at or beyond @pos can have moved.  */
+	closure.pos = NULL;
+	closure.objs = NULL;
+	if (pos->col < gnm_sheet_get_max_cols (sheet)) {
+		range_init_cols (&r, sheet, pos->col,
+				 gnm_sheet_get_last_col (sheet));
+		gnm_rtree_foreach_overlapping (sheet->object_index, &r,
+			(GnmRTreeFunc)cb_collect_moved_object, &closure);
+	}
+	if (pos->col > 0 && pos->row < gnm_sheet_get_max_rows (sheet)) {
+		closure.pos = pos;
+		range_init (&r, 0, pos->row,
+			    pos->col - 1, gnm_sheet_get_last_row (sheet));
+		gnm_rtree_foreach_overlapping (sheet->object_index, &r,
+			(GnmRTreeFunc)cb_collect_moved_object, &closure);
+	}
+
+	for (ptr = closure.objs; ptr != NULL ; ptr = ptr->next)
 		sheet_object_update_bounds (SHEET_OBJECT (ptr->data), pos);
+	g_slist_free (closure.objs);
 }
 
 /**
@@ -1905,16 +1934,9 @@ sheet_update (Sheet const *sheet)
 GnmCell *
 sheet_cell_get (Sheet const *sheet, int col, int row)
 {
-	GnmCell *cell;
-	GnmCell key;
-
 	g_return_val_if_fail (IS_SHEET (sheet), NULL);
 
-	key.pos.col = col;
-	key.pos.row = row;
-	cell = g_hash_table_lookup (sheet->cell_hash, &key);
-
-	return cell;
+	return gnm_cell_tiles_get (sheet->cell_tiles, col, row);
 }
 
 /**
@@ -3640,6 +3662,7 @@ sheet_foreach_cell_in_range (Sheet *sheet, CellIterFlags flags,
 {
 	GnmValue *cont;
 	GnmCellIter iter;
+	GnmCellTilesBand band;
 	gboolean const visiblity_matters = (flags & CELL_ITER_IGNORE_HIDDEN) != 0;
 	gboolean const subtotal_magic = (flags & CELL_ITER_IGNORE_SUBTOTAL) != 0;
 	gboolean const only_existing = (flags & CELL_ITER_IGNORE_NONEXISTENT) != 0;
@@ -3664,6 +3687,10 @@ sheet_foreach_cell_in_range (Sheet *sheet, CellIterFlags flags,
 			end_row = sheet->rows.max_used;
 	}
 
+	/* Fetch the tiles once per band of rows, not once per cell */
+	gnm_cell_tiles_band_init (&band, sheet->cell_tiles,
+				  start_col, MAX (start_col, end_col));
+
 	for (iter.pp.eval.row = start_row; iter.pp.eval.row <= end_row; ++iter.pp.eval.row) {
 		iter.ri = sheet_row_get (iter.pp.sheet, iter.pp.eval.row);
 
@@ -3682,7 +3709,7 @@ sheet_foreach_cell_in_range (Sheet *sheet, CellIterFlags flags,
 				for (iter.pp.eval.col = start_col; iter.pp.eval.col <= end_col; ++iter.pp.eval.col) {
 					cont = (*callback) (&iter, closure);
 					if (cont != NULL)
-						return cont;
+						goto out;
 				}
 			}
 
@@ -3699,7 +3726,7 @@ sheet_foreach_cell_in_range (Sheet *sheet, CellIterFlags flags,
 			if (iter.ci != NULL) {
 				if (visiblity_matters && !iter.ci->visible)
 					continue;
-				iter.cell = sheet_cell_get (sheet,
+				iter.cell = gnm_cell_tiles_band_get (&band,
 					iter.pp.eval.col, iter.pp.eval.row);
 			} else
 				iter.cell = NULL;
@@ -3721,10 +3748,13 @@ sheet_foreach_cell_in_range (Sheet *sheet, CellIterFlags flags,
 
 			cont = (*callback) (&iter, closure);
 			if (cont != NULL)
-				return cont;
+				goto out;
 		}
 	}
-	return NULL;
+	cont = NULL;
+out:
+	gnm_cell_tiles_band_clear (&band);
+	return cont;
 }
 
 /**
@@ -3740,7 +3770,7 @@ sheet_cell_foreach (Sheet const *sheet, GHFunc callback, gpointer data)
 {
 	g_return_if_fail (IS_SHEET (sheet));
 
-	g_hash_table_foreach (sheet->cell_hash, callback, data);
+	gnm_cell_tiles_foreach (sheet->cell_tiles, callback, data);
 }
 
 /**
@@ -3752,7 +3782,7 @@ sheet_cell_foreach (Sheet const *sheet, GHFunc callback, gpointer data)
 unsigned
 sheet_cells_count (Sheet const *sheet)
 {
-	return g_hash_table_size (sheet->cell_hash);
+	return gnm_cell_tiles_size (sheet->cell_tiles);
 }
 
 static void
@@ -3875,7 +3905,7 @@ sheet_cell_add_to_hash (Sheet *sheet, GnmCell *cell)
 
 	gnm_cell_unrender (cell);
 
-	g_hash_table_insert (sheet->cell_hash, cell, cell);
+	gnm_cell_tiles_insert (sheet->cell_tiles, cell);
 
 	if (gnm_sheet_merge_is_corner (sheet, &cell->pos))
 		cell->base.flags |= GNM_CELL_IS_MERGED;
@@ -3982,6 +4012,122 @@ sheet_cell_create (Sheet *sheet, int col, int row)
 	return cell;
 }
 
+/****************************************************************************/
+
+/*
+ * Importers create cells by the million.  A GnmCellLoader stores their
+ * contents without linking expressions into the dependency containers,
+ * and links everything in one pass when the sheet is done.  Expressions
+ * that get overwritten before then are never linked at all.
+ */
+struct _GnmCellLoader {
+	Sheet  *sheet;
+	GArray *pending;	/* GnmCellPos of unlinked expressions */
+	guint	n_cells;	/* size hint, 0 if unknown */
+};
+
+/* An importer's hint counts all cells, not just expressions, so do not
+ * let a huge sparse sheet reserve more than this up front.  */
+#define CELL_LOADER_MAX_RESERVE	(1u << 20)
+
+GnmCellLoader *
+gnm_cell_loader_new (Sheet *sheet)
+{
+	GnmCellLoader *loader;
+
+	g_return_val_if_fail (IS_SHEET (sheet), NULL);
+
+	loader = g_new (GnmCellLoader, 1);
+	loader->sheet = sheet;
+	loader->pending = NULL;
+	loader->n_cells = 0;
+	return loader;
+}
+
+/**
+ * gnm_cell_loader_set_size_hint :
+ * @loader :
+ * @n_cells : the number of cells the importer expects, an upper bound
+ *	will do.
+ *
+ * Lets @loader size its storage once rather than grow it.  Only useful
+ * before the first expression is stored.
+ **/
+void
+gnm_cell_loader_set_size_hint (GnmCellLoader *loader, guint n_cells)
+{
+	g_return_if_fail (loader != NULL);
+	loader->n_cells = n_cells;
+}
+
+/**
+ * gnm_cell_loader_set_expr :
+ * @loader :
+ * @cell : a cell of the loader's sheet
+ * @texpr : expression, a reference is added.
+ * @v : the value computed last time, absorbed.  NULL to have the cell
+ *	recalculated.
+ *
+ * Stores @texpr in @cell without linking it, see gnm_cell_loader_finish.
+ **/
+void
+gnm_cell_loader_set_expr (GnmCellLoader *loader, GnmCell *cell,
+			  GnmExprTop const *texpr, GnmValue *v)
+{
+	g_return_if_fail (loader != NULL);
+	g_return_if_fail (cell != NULL);
+	g_return_if_fail (cell->base.sheet == loader->sheet);
+
+	gnm_cell_set_expr_and_value (cell, texpr,
+		(v != NULL) ? v : value_new_empty (), FALSE);
+	/* Linking puts it in the dirty set */
+	if (v == NULL)
+		cell->base.flags |= DEPENDENT_NEEDS_RECALC;
+
+	if (loader->pending == NULL)
+		loader->pending = g_array_sized_new (FALSE, FALSE,
+			sizeof (GnmCellPos),
+			(loader->n_cells > 0)
+			? MIN (loader->n_cells, CELL_LOADER_MAX_RESERVE)
+			: 1024);
+	g_array_append_val (loader->pending, cell->pos);
+}
+
+/**
+ * gnm_cell_loader_finish :
+ * @loader :
+ *
+ * Links the expressions stored through @loader that are still in place
+ * and frees @loader.
+ **/
+void
+gnm_cell_loader_finish (GnmCellLoader *loader)
+{
+	Workbook *wb;
+	guint i;
+
+	if (loader == NULL)
+		return;
+
+	if (loader->pending != NULL) {
+		wb = loader->sheet->workbook;
+		dependents_batch_begin (wb);
+		for (i = 0; i < loader->pending->len; i++) {
+			GnmCellPos const *pos = &g_array_index
+				(loader->pending, GnmCellPos, i);
+			GnmCell *cell = sheet_cell_get (loader->sheet,
+							pos->col, pos->row);
+			if (cell != NULL && gnm_cell_has_expr (cell) &&
+			    !gnm_cell_expr_is_linked (cell))
+				dependent_link (GNM_CELL_TO_DEP (cell));
+		}
+		dependents_batch_end (wb);
+		g_array_free (loader->pending, TRUE);
+	}
+
+	g_free (loader);
+}
+
 /**
  * sheet_cell_remove_from_hash :
  *
@@ -3994,7 +4140,7 @@ sheet_cell_remove_from_hash (Sheet *sheet, GnmCell *cell)
 	cell_unregister_span (cell);
 	if (gnm_cell_expr_is_linked (cell))
 		dependent_unlink (GNM_CELL_TO_DEP (cell));
-	g_hash_table_remove (sheet->cell_hash, cell);
+	gnm_cell_tiles_remove (sheet->cell_tiles, cell);
 	cell->base.flags &= ~(GNM_CELL_IN_SHEET_LIST|GNM_CELL_IS_MERGED);
 }
 
@@ -4006,10 +4152,12 @@ static void
 sheet_cell_destroy (Sheet *sheet, GnmCell *cell, gboolean queue_recalc)
 {
 	if (gnm_cell_expr_is_linked (cell)) {
-		/* if it needs recalc then its depends are already queued
+		/* if it needs recalc then its depends are already queued,
+		 * but only to check whether its value changes.  It never
+		 * will now, so queue them for a full recalc.
 		 * check recalc status before we unlink
 		 */
-		queue_recalc &= !gnm_cell_needs_recalc (cell);
+		queue_recalc |= gnm_cell_needs_recalc (cell);
 		dependent_unlink (GNM_CELL_TO_DEP (cell));
 	}
 
@@ -4079,6 +4227,7 @@ sheet_col_destroy (Sheet *sheet, int const col, gboolean free_cells)
 
 	(*segment)->info[sub] = NULL;
 	colrow_free (ci);
+	colrow_sizes_changed (&sheet->cols, col);
 
 	/* Use >= just in case things are screwed up */
 	if (col >= sheet->cols.max_used) {
@@ -4119,6 +4268,7 @@ sheet_row_destroy (Sheet *sheet, int const row, gboolean free_cells)
 
 	(*segment)->info[sub] = NULL;
 	colrow_free (ri);
+	colrow_sizes_changed (&sheet->rows, row);
 
 	/* Use >= just in case things are screwed up */
 	if (row >= sheet->rows.max_used) {
@@ -4177,10 +4327,14 @@ sheet_destroy_contents (Sheet *sheet)
 		if (sheet->sheet_objects != NULL)
 			g_warning ("There is a problem with sheet objects");
 	}
+	gnm_rtree_free (sheet->object_index);
+	sheet->object_index = NULL;
 
 	/* The memory is managed by Sheet::list_merged */
 	g_hash_table_destroy (sheet->hash_merged);
 	sheet->hash_merged = NULL;
+	gnm_rtree_free (sheet->tree_merged);
+	sheet->tree_merged = NULL;
 
 	go_slist_free_custom (sheet->list_merged, g_free);
 	sheet->list_merged = NULL;
@@ -4191,7 +4345,8 @@ sheet_destroy_contents (Sheet *sheet)
 
 	/* Remove all the cells */
 	sheet_cell_foreach (sheet, (GHFunc) &cb_remove_allcells, NULL);
-	g_hash_table_destroy (sheet->cell_hash);
+	gnm_cell_tiles_free (sheet->cell_tiles);
+	sheet->cell_tiles = NULL;
 
 	/* Delete in ascending order to avoid decrementing max_used each time */
 	for (i = 0; i <= max_col; ++i)
@@ -4204,10 +4359,18 @@ sheet_destroy_contents (Sheet *sheet)
 	colrow_resize (&sheet->cols, 0);
 	g_ptr_array_free (sheet->cols.info, TRUE);
 	sheet->cols.info = NULL;
+	g_free (sheet->cols.start_pts);
+	sheet->cols.start_pts = NULL;
+	g_free (sheet->cols.start_pixels);
+	sheet->cols.start_pixels = NULL;
 
 	colrow_resize (&sheet->rows, 0);
 	g_ptr_array_free (sheet->rows.info, TRUE);
 	sheet->rows.info = NULL;
+	g_free (sheet->rows.start_pts);
+	sheet->rows.start_pts = NULL;
+	g_free (sheet->rows.start_pixels);
+	sheet->rows.start_pixels = NULL;
 }
 
 /**
@@ -4488,6 +4651,7 @@ colrow_move (Sheet *sheet,
 
 	/* Update the position */
 	segment->info [COLROW_SUB_INDEX (old_pos)] = NULL;
+	colrow_sizes_changed (info_collection, old_pos);
 	/* TODO : Figure out a way to merge these functions */
 	if (is_cols)
 		sheet_col_add (sheet, info, new_pos);
@@ -5188,9 +5352,8 @@ static void
 sheet_colrow_default_calc (Sheet *sheet, double units,
 			   gboolean is_cols, gboolean is_pts)
 {
-	ColRowInfo *cri = is_cols
-		? &sheet->cols.default_style
-		: &sheet->rows.default_style;
+	ColRowCollection *infos = is_cols ? &sheet->cols : &sheet->rows;
+	ColRowInfo *cri = &infos->default_style;
 
 	g_return_if_fail (units > 0.);
 
@@ -5206,6 +5369,7 @@ sheet_colrow_default_calc (Sheet *sheet, double units,
 		cri->size_pixels = units;
 		colrow_compute_pts_from_pixels (cri, sheet, is_cols, -1);
 	}
+	colrow_sizes_changed (infos, 0);
 }
 
 /************************************************************************/
@@ -5221,35 +5385,18 @@ sheet_colrow_default_calc (Sheet *sheet, double units,
 double
 sheet_col_get_distance_pts (Sheet const *sheet, int from, int to)
 {
-	ColRowInfo const *ci;
-	double dflt, pts = 0., sign = 1.;
-	int i;
+	double pts;
 
 	g_return_val_if_fail (IS_SHEET (sheet), 1.);
-
-	if (from > to) {
-		int const tmp = to;
-		to = from;
-		from = tmp;
-		sign = -1.;
-	}
-
-	g_return_val_if_fail (from >= 0, 1.);
+	g_return_val_if_fail (from >= 0 && to >= 0, 1.);
+	g_return_val_if_fail (from <= gnm_sheet_get_max_cols (sheet), 1.);
 	g_return_val_if_fail (to <= gnm_sheet_get_max_cols (sheet), 1.);
 
-	/* Do not use colrow_foreach, it ignores empties */
-	dflt =  sheet->cols.default_style.size_pts;
-	for (i = from ; i < to ; ++i) {
-		if (NULL == (ci = sheet_col_get (sheet, i)))
-			pts += dflt;
-		else if (ci->visible)
-			pts += ci->size_pts;
-	}
-
+	pts = colrow_get_distance_pts (&sheet->cols, from, to);
 	if (sheet->display_formulas)
 		pts *= 2.;
 
-	return pts * sign;
+	return pts;
 }
 
 /**
@@ -5261,32 +5408,12 @@ sheet_col_get_distance_pts (Sheet const *sheet, int from, int to)
 int
 sheet_col_get_distance_pixels (Sheet const *sheet, int from, int to)
 {
-	ColRowInfo const *ci;
-	int dflt, pixels = 0, sign = 1;
-	int i;
-
-	g_return_val_if_fail (IS_SHEET (sheet), 1.);
-
-	if (from > to) {
-		int const tmp = to;
-		to = from;
-		from = tmp;
-		sign = -1;
-	}
-
-	g_return_val_if_fail (from >= 0, 1);
+	g_return_val_if_fail (IS_SHEET (sheet), 1);
+	g_return_val_if_fail (from >= 0 && to >= 0, 1);
+	g_return_val_if_fail (from <= gnm_sheet_get_max_cols (sheet), 1);
 	g_return_val_if_fail (to <= gnm_sheet_get_max_cols (sheet), 1);
 
-	/* Do not use colrow_foreach, it ignores empties */
-	dflt =  sheet->cols.default_style.size_pts;
-	for (i = from ; i < to ; ++i) {
-		if (NULL == (ci = sheet_col_get (sheet, i)))
-			pixels += dflt;
-		else if (ci->visible)
-			pixels += ci->size_pixels;
-	}
-
-	return pixels * sign;
+	return colrow_get_distance_pixels (&sheet->cols, from, to);
 }
 
 /**
@@ -5317,6 +5444,7 @@ sheet_col_set_size_pts (Sheet *sheet, int col, double width_pts,
 
 	ci->size_pts = width_pts;
 	colrow_compute_pixels_from_pts (ci, sheet, TRUE, -1);
+	colrow_sizes_changed (&sheet->cols, col);
 
 	sheet->priv->recompute_visibility = TRUE;
 	sheet_flag_recompute_spans (sheet);
@@ -5340,6 +5468,7 @@ sheet_col_set_size_pixels (Sheet *sheet, int col, int width_pixels,
 
 	ci->size_pixels = width_pixels;
 	colrow_compute_pts_from_pixels (ci, sheet, TRUE, -1);
+	colrow_sizes_changed (&sheet->cols, col);
 
 	sheet->priv->recompute_visibility = TRUE;
 	sheet_flag_recompute_spans (sheet);
@@ -5402,47 +5531,12 @@ sheet_col_set_default_size_pixels (Sheet *sheet, int width_pixels)
 double
 sheet_row_get_distance_pts (Sheet const *sheet, int from, int to)
 {
-	ColRowSegment const *segment;
-	ColRowInfo const *ri;
-	double const default_size = sheet->rows.default_style.size_pts;
-	double pts = 0., sign = 1.;
-	int i;
-
 	g_return_val_if_fail (IS_SHEET (sheet), 1.);
-
-	if (from > to) {
-		int const tmp = to;
-		to = from;
-		from = tmp;
-		sign = -1.;
-	}
-
-	g_return_val_if_fail (from >= 0, 1.);
+	g_return_val_if_fail (from >= 0 && to >= 0, 1.);
+	g_return_val_if_fail (from <= gnm_sheet_get_max_rows (sheet), 1.);
 	g_return_val_if_fail (to <= gnm_sheet_get_max_rows (sheet), 1.);
 
-	/* Do not use colrow_foreach, it ignores empties.
-	 * Optimize this so that long jumps are not quite so horrific
-	 * for performance.
-	 */
-	for (i = from ; i < to ; ++i) {
-		segment = COLROW_GET_SEGMENT (&(sheet->rows), i);
-
-		if (segment != NULL) {
-			ri = segment->info[COLROW_SUB_INDEX (i)];
-			if (ri == NULL)
-				pts += default_size;
-			else if (ri->visible)
-				pts += ri->size_pts;
-		} else {
-			int segment_end = COLROW_SEGMENT_END (i)+1;
-			if (segment_end > to)
-				segment_end = to;
-			pts += default_size * (segment_end - i);
-			i = segment_end-1;
-		}
-	}
-
-	return pts*sign;
+	return colrow_get_distance_pts (&sheet->rows, from, to);
 }
 
 /**
@@ -5473,6 +5567,7 @@ sheet_row_set_size_pts (Sheet *sheet, int row, double height_pts,
 
 	ri->size_pts = height_pts;
 	colrow_compute_pixels_from_pts (ri, sheet, FALSE, -1);
+	colrow_sizes_changed (&sheet->rows, row);
 
 	sheet->priv->recompute_visibility = TRUE;
 	if (sheet->priv->reposition_objects.row > row)
@@ -5506,6 +5601,7 @@ sheet_row_set_size_pixels (Sheet *sheet, int row, int height_pixels,
 
 	ri->size_pixels = height_pixels;
 	colrow_compute_pts_from_pixels (ri, sheet, FALSE, -1);
+	colrow_sizes_changed (&sheet->rows, row);
 
 	sheet->priv->recompute_visibility = TRUE;
 	if (sheet->priv->reposition_objects.row > row)
@@ -5604,21 +5700,6 @@ sheet_dup_colrows (Sheet const *src, Sheet *dst)
 	dst->rows.max_outline_level = src->rows.max_outline_level;
 }
 
-static void
-sheet_dup_styles (Sheet const *src, Sheet *dst)
-{
-	static GnmCellPos const	corner = { 0, 0 };
-	GnmRange	 r;
-	GnmStyleList	*styles;
-
-	sheet_style_set_auto_pattern_color (
-		dst, sheet_style_get_auto_pattern_color (src));
-
-	styles = sheet_style_get_range (src, range_init_full_sheet (&r, src));
-	sheet_style_set_list (dst, &corner, styles, NULL, NULL);
-	style_list_free	(styles);
-}
-
 static void
 sheet_dup_merged_regions (Sheet const *src, Sheet *dst)
 {
@@ -5679,10 +5760,11 @@ sheet_dup_names (Sheet const *src, Sheet *dst)
 }
 
 static void
-cb_sheet_cell_copy (gpointer unused, gpointer key, gpointer new_sheet_param)
+cb_sheet_cell_copy (gpointer unused, gpointer key, gpointer loader_param)
 {
 	GnmCell const *cell = key;
-	Sheet *dst = new_sheet_param;
+	GnmCellLoader *loader = loader_param;
+	Sheet *dst = loader->sheet;
 	Sheet *src;
 	GnmExprArrayCorner const *array;
 	GnmExprTop const *texpr;
@@ -5711,7 +5793,7 @@ cb_sheet_cell_copy (gpointer unused, gpointer key, gpointer new_sheet_param)
 		GnmCell *new_cell = sheet_cell_create (dst, cell->pos.col, cell->pos.row);
 		if (gnm_cell_has_expr (cell)) {
 			texpr = gnm_expr_top_relocate_sheet (texpr, src, dst);
-			gnm_cell_set_expr_and_value (new_cell, texpr, value_new_empty (), TRUE);
+			gnm_cell_loader_set_expr (loader, new_cell, texpr, NULL);
 			gnm_expr_top_unref (texpr);
 		} else
 			gnm_cell_set_value (new_cell, value_dup (cell->value));
@@ -5721,7 +5803,12 @@ cb_sheet_cell_copy (gpointer unused, gpointer key, gpointer new_sheet_param)
 static void
 sheet_dup_cells (Sheet const *src, Sheet *dst)
 {
-	sheet_cell_foreach (src, &cb_sheet_cell_copy, dst);
+	GnmCellLoader *loader = gnm_cell_loader_new (dst);
+
+	gnm_cell_loader_set_size_hint (loader, sheet_cells_count (src));
+	/* Link the copied expressions in one pass at the end.  */
+	sheet_cell_foreach (src, &cb_sheet_cell_copy, loader);
+	gnm_cell_loader_finish (loader);
 	sheet_region_queue_recalc (dst, NULL);
 }
 
@@ -5739,6 +5826,11 @@ sheet_dup_filters (Sheet const *src, Sheet *dst)
  * @src : #Sheet
  *
  * Create a new Sheet and return it.
+ *
+ * Everything is copied, nothing is shared with @src.  Cells are
+ * dependents of their own sheet and point back at it, and styles are
+ * linked to a single sheet that counts their uses, so neither can be
+ * shared copy-on-write without changing every path that writes to them.
  **/
 Sheet *
 sheet_dup (Sheet const *src)
@@ -5780,7 +5872,7 @@ sheet_dup (Sheet const *src)
 	print_info_free (dst->print_info);
 	dst->print_info = print_info_dup (src->print_info);
 
-	sheet_dup_styles         (src, dst);
+	sheet_style_dup          (src, dst);
 	sheet_dup_merged_regions (src, dst);
 	sheet_dup_colrows	 (src, dst);
 	sheet_dup_names		 (src, dst);
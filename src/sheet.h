@@ -45,7 +45,7 @@ struct _Sheet {
 
 	ColRowCollection cols, rows;
 
-	GHashTable  *cell_hash;	/* The cells in hashed format */
+	GnmCellTiles *cell_tiles; /* The cells, by position */
 
 	GnmNamedExprCollection *names;
 
@@ -54,6 +54,7 @@ struct _Sheet {
 	GnmRenderedValueCollection *rendered_values;
 
 	GSList      *sheet_objects;	/* List of objects in this sheet */
+	GnmRTree    *object_index;	/* The same, by anchor */
 	GnmCellPos   max_object_extent;
 
 	/* Sheet level preferences */
@@ -103,6 +104,7 @@ struct _Sheet {
 	GSList		 *filters;
 	GSList		 *list_merged;
 	GHashTable	 *hash_merged;
+	GnmRTree	 *tree_merged;
 	SheetPrivate     *priv;
 	PrintInformation *print_info;
 	GnmColor	 *tab_color;
@@ -145,6 +147,14 @@ GnmSheetSize const *gnm_sheet_get_size2 (Sheet const *sheet,
 GnmCell  *sheet_cell_get	 (Sheet const *sheet, int col, int row);
 GnmCell  *sheet_cell_fetch	 (Sheet *sheet, int col, int row);
 GnmCell  *sheet_cell_create	 (Sheet *sheet, int col, int row);
+
+GnmCellLoader *gnm_cell_loader_new	  (Sheet *sheet);
+void	  gnm_cell_loader_set_size_hint (GnmCellLoader *loader,
+					 guint n_cells);
+void	  gnm_cell_loader_set_expr   (GnmCellLoader *loader, GnmCell *cell,
+				      GnmExprTop const *texpr, GnmValue *v);
+void	  gnm_cell_loader_finish     (GnmCellLoader *loader);
+
 void      sheet_cell_remove	 (Sheet *sheet, GnmCell *cell,
 				  gboolean redraw, gboolean queue_recalc);
 /* TODO TODO TODO
@@ -393,8 +403,8 @@ do {										\
 		SHEET_VIEW_FOREACH_CONTROL(view, control, code);)
 
 /*
- * Walk the dependents.  WARNING: Note, that it is only valid to muck with
- * the current dependency in the code.
+ * Walk the dependents.  WARNING: Note, that the code must not link or
+ * unlink dependents, use SHEET_FOREACH_DEPENDENT_SAFE for that.
  */
 #define SHEET_FOREACH_DEPENDENT(sheet, dep, code)					\
   do {											\
@@ -405,6 +415,13 @@ do {										\
 	}										\
   } while (0)
 
+#define SHEET_FOREACH_DEPENDENT_SAFE(sheet, dep, code)					\
+  do {											\
+	if ((sheet)->deps) {								\
+		DEPENDENT_CONTAINER_FOREACH_DEPENDENT_SAFE ((sheet)->deps, dep, code);	\
+	}										\
+  } while (0)
+
 G_END_DECLS
 
 #endif /* _GNM_SHEET_H_ */
@@ -21,6 +21,9 @@
 #include "sheet.h"
 #include "dependent.h"
 #include "expr-name.h"
+#include "expr.h"
+#include "value.h"
+#include "ranges.h"
 #include "libgnumeric.h"
 #include "gutils.h"
 #include "gnumeric-paths.h"
@@ -28,6 +31,7 @@
 #include "command-context.h"
 #include "command-context-stderr.h"
 #include "workbook-view.h"
+#include "recalc-profile.h"
 #include <dialogs/dialogs.h>
 #include <goffice/goffice.h>
 #include <gsf/gsf-utils.h>
@@ -49,6 +53,8 @@ static char *ssconvert_export_id = NULL;
 static char *ssconvert_export_options = NULL;
 static char *ssconvert_merge_target = NULL;
 static char **ssconvert_goal_seek = NULL;
+static char *ssconvert_profile_recalc = NULL;
+static char **ssconvert_recalc_targets = NULL;
 
 static const GOptionEntry ssconvert_options [] = {
 	{
@@ -125,6 +131,20 @@ static const GOptionEntry ssconvert_options [] = {
 		NULL
 	},
 
+	{
+		"recalc-only", 0,
+		0, G_OPTION_ARG_STRING_ARRAY, &ssconvert_recalc_targets,
+		N_("Only compute what TARGET needs: a sheet, a range or a name.  May be repeated"),
+		N_("TARGET")
+	},
+
+	{
+		"profile-recalc", 0,
+		0, G_OPTION_ARG_FILENAME, &ssconvert_profile_recalc,
+		N_("Write a recalc profile (CSV, or JSON for .json) to FILE"),
+		N_("FILE")
+	},
+
 
 	/* ---------------------------------------- */
 
@@ -178,6 +198,70 @@ setup_range (GObject *obj, const char *key, Workbook *wb, const char *rtxt)
 				g_free);
 }
 
+static GSList *
+add_recalc_target (GSList *targets, Workbook *wb, const char *txt)
+{
+	GnmParsePos pp;
+	GnmNamedExpr *nexpr;
+	GnmRangeRef rr;
+	GnmRange r;
+	Sheet *start_sheet, *end_sheet;
+	Sheet *sheet = workbook_sheet_by_name (wb, txt);
+	int i;
+
+	if (sheet != NULL)
+		return g_slist_prepend (targets,
+			gnm_sheet_range_new (sheet,
+				range_init_full_sheet (&r, sheet)));
+
+	parse_pos_init (&pp, wb, workbook_sheet_by_index (wb, 0), 0, 0);
+
+	nexpr = expr_name_lookup (&pp, txt);
+	if (nexpr != NULL && expr_name_is_active (nexpr)) {
+		GnmValue *v = gnm_expr_top_get_range (nexpr->texpr);
+		if (v == NULL) {
+			g_printerr (_("Name '%s' does not refer to a range.\n"),
+				    txt);
+			exit (1);
+		}
+		rr = v->v_range.cell;
+		value_release (v);
+		if (nexpr->pos.sheet != NULL)
+			pp.sheet = nexpr->pos.sheet;
+	} else {
+		const char *end = rangeref_parse (&rr, txt, &pp,
+						  gnm_conventions_default);
+		if (!end || end == txt || *end != 0) {
+			g_printerr (_("Invalid recalc target '%s'.\n"), txt);
+			exit (1);
+		}
+	}
+
+	gnm_rangeref_normalize_pp (&rr, &pp, &start_sheet, &end_sheet, &r);
+	if (end_sheet == NULL)
+		end_sheet = start_sheet;
+	for (i = start_sheet->index_in_wb; i <= end_sheet->index_in_wb; i++)
+		targets = g_slist_prepend (targets,
+			gnm_sheet_range_new (workbook_sheet_by_index (wb, i), &r));
+
+	return targets;
+}
+
+static void
+recalc_targets (Workbook *wb)
+{
+	GSList *targets = NULL;
+	int i;
+
+	for (i = 0; ssconvert_recalc_targets[i]; i++)
+		targets = add_recalc_target (targets, wb,
+					     ssconvert_recalc_targets[i]);
+
+	targets = g_slist_reverse (targets);
+	workbook_recalc_cone (wb, targets);
+	go_slist_free_custom (targets, (GFreeFunc)gnm_sheet_range_free);
+}
+
 static int
 handle_export_options (GOFileSaver *fs, GODoc *doc)
 {
@@ -591,6 +675,13 @@ convert (char const *inarg, char const *outarg, char const *mergeargs[],
 	if (!fs)
 		goto out;
 
+	if (ssconvert_profile_recalc)
+		gnm_recalc_profile_set_enabled (TRUE);
+
+	/* The targets are computed once everything else is in place */
+	if (ssconvert_recalc_targets)
+		wb_view_set_recalc_after_load (FALSE);
+
 	io_context = go_io_context_new (cc);
 	if (mergeargs == NULL) {
 		wbv = wb_view_new_from_uri (infile, fo,
@@ -607,6 +698,8 @@ convert (char const *inarg, char const *outarg, char const *mergeargs[],
 	}
 
 	wb = wb_view_get_workbook (wbv);
+	if (gnm_debug_flag ("dep-stats"))
+		dependents_dump_stats (wb);
 
 	res = handle_export_options (fs, GO_DOC (wb));
 	if (res) {
@@ -637,11 +730,25 @@ convert (char const *inarg, char const *outarg, char const *mergeargs[],
 		run_solver (sheet, wbv);
 	}
 
-	if (ssconvert_recalc)
+	if (ssconvert_recalc_targets) {
+		if (ssconvert_recalc)
+			workbook_queue_all_recalc (wb);
+		recalc_targets (wb);
+	} else if (ssconvert_recalc)
 		workbook_recalc_all (wb);
 	else
 		workbook_recalc (wb);
 
+	if (ssconvert_profile_recalc) {
+		GError *err = NULL;
+		gnm_recalc_profile_set_enabled (FALSE);
+		if (!gnm_recalc_profile_save (ssconvert_profile_recalc, &err)) {
+			g_printerr (_("Unable to write recalc profile: %s\n"),
+				    err->message);
+			g_error_free (err);
+		}
+	}
+
 	if (ssconvert_range)
 		setup_range (G_OBJECT (wb),
 			     "ssconvert-range",
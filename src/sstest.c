@@ -22,11 +22,16 @@
 #include "func.h"
 #include "parse-util.h"
 #include "sheet-object-cell-comment.h"
+#include "ranges.h"
+#include "dependent.h"
+#include "recalc-profile.h"
 
 #include <gsf/gsf-input-stdio.h>
 #include <gsf/gsf-input-textline.h>
 #include <glib/gi18n.h>
+#include <glib/gstdio.h>
 #include <string.h>
+#include <stdlib.h>
 
 static gboolean sstest_show_version = FALSE;
 
@@ -194,6 +199,319 @@ test_insdel_rowcol_names (void)
 	mark_test_end (test_name);
 }
 
+static void
+dump_cell (Sheet *sheet, const char *name, int col, int row)
+{
+	GnmCell *cell = sheet_cell_get (sheet, col, row);
+	char *txt = (cell && cell->value)
+		? value_get_as_string (cell->value)
+		: g_strdup ("(empty)");
+	g_printerr ("%s = %s\n", name, txt);
+	g_free (txt);
+}
+
+static void
+test_recalc_deleted_precedent (void)
+{
+	Workbook *wb;
+	Sheet *sheet;
+	const char *test_name = "test_recalc_deleted_precedent";
+
+	mark_test_start (test_name);
+
+	wb = workbook_new ();
+	sheet = workbook_sheet_add (wb, -1,
+				    GNM_DEFAULT_COLS, GNM_DEFAULT_ROWS);
+	workbook_set_recalcmode (wb, FALSE);
+
+	sheet_cell_set_text (sheet_cell_fetch (sheet, 0, 0), "1", NULL);
+	sheet_cell_set_text (sheet_cell_fetch (sheet, 1, 0), "=A1*2", NULL);
+	sheet_cell_set_text (sheet_cell_fetch (sheet, 2, 0), "=B1+1", NULL);
+	workbook_recalc (wb);
+	dump_cell (sheet, "C1", 2, 0);
+
+	g_printerr ("Changing A1 without recalc, then deleting B1.\n");
+	sheet_cell_set_text (sheet_cell_fetch (sheet, 0, 0), "10", NULL);
+	sheet_clear_region (sheet, 1, 0, 1, 0,
+			    CLEAR_VALUES | CLEAR_RECALC_DEPS, NULL);
+	workbook_recalc (wb);
+	dump_cell (sheet, "B1", 1, 0);
+	dump_cell (sheet, "C1", 2, 0);
+
+	g_object_unref (wb);
+
+	mark_test_end (test_name);
+}
+
+static void
+test_cached_array_roundtrip (void)
+{
+	Workbook *wb;
+	WorkbookView *wbv;
+	Sheet *sheet;
+	GnmParsePos pp;
+	GnmExprTop const *texpr;
+	GnmRange r;
+	GOCmdContext *cc;
+	GOIOContext *io_context;
+	char *filename, *uri;
+	const char *test_name = "test_cached_array_roundtrip";
+
+	mark_test_start (test_name);
+
+	wb = workbook_new ();
+	sheet = workbook_sheet_add (wb, -1,
+				    GNM_DEFAULT_COLS, GNM_DEFAULT_ROWS);
+	wbv = workbook_view_new (wb);
+
+	sheet_cell_set_text (sheet_cell_fetch (sheet, 0, 0), "3", NULL);
+	sheet_cell_set_text (sheet_cell_fetch (sheet, 1, 0), "=A1*2", NULL);
+	texpr = gnm_expr_parse_str ("A1*{1,2}",
+				    parse_pos_init (&pp, wb, sheet, 2, 0),
+				    GNM_EXPR_PARSE_DEFAULT, NULL, NULL);
+	range_init (&r, 2, 0, 3, 0);
+	gnm_cell_set_array (sheet, &r, texpr);
+	gnm_expr_top_unref (texpr);
+	workbook_recalc (wb);
+	dump_cell (sheet, "B1", 1, 0);
+	dump_cell (sheet, "C1", 2, 0);
+	dump_cell (sheet, "D1", 3, 0);
+
+	g_printerr ("Saving with cached values and loading again.\n");
+	filename = g_build_filename (g_get_tmp_dir (),
+				     "sstest-cached-array.gnumeric", NULL);
+	uri = go_filename_to_uri (filename);
+	cc = cmd_context_stderr_new ();
+	wb_view_save_as (wbv, go_file_saver_for_id ("Gnumeric_XmlIO:sax"),
+			 uri, cc);
+	g_object_unref (wb);
+
+	io_context = go_io_context_new (cc);
+	wbv = wb_view_new_from_uri (uri, NULL, io_context, NULL);
+	g_object_unref (io_context);
+	g_object_unref (cc);
+	g_unlink (filename);
+	g_free (filename);
+	g_free (uri);
+
+	if (wbv == NULL) {
+		g_printerr ("Failed to load.\n");
+	} else {
+		wb = wb_view_get_workbook (wbv);
+		sheet = workbook_sheet_by_index (wb, 0);
+		workbook_recalc (wb);
+		dump_cell (sheet, "B1", 1, 0);
+		dump_cell (sheet, "C1", 2, 0);
+		dump_cell (sheet, "D1", 3, 0);
+		g_object_unref (wb);
+	}
+
+	mark_test_end (test_name);
+}
+
+static gulong
+profile_func_count (char const *filename, char const *func)
+{
+	char *contents, **lines, *prefix;
+	gulong res = 0;
+	int i;
+
+	if (!g_file_get_contents (filename, &contents, NULL, NULL))
+		return 0;
+	/* Function rows have no expression column */
+	prefix = g_strconcat ("function,", func, ",,", NULL);
+	lines = g_strsplit (contents, "\n", -1);
+	for (i = 0; lines[i]; i++)
+		if (g_ascii_strncasecmp (lines[i], prefix, strlen (prefix)) == 0)
+			res = strtoul (lines[i] + strlen (prefix), NULL, 10);
+	g_strfreev (lines);
+	g_free (prefix);
+	g_free (contents);
+	return res;
+}
+
+static void
+test_name_eval_once (void)
+{
+	Workbook *wb;
+	Sheet *sheet;
+	char *filename;
+	int i;
+	const char *test_name = "test_name_eval_once";
+
+	mark_test_start (test_name);
+
+	wb = workbook_new ();
+	sheet = workbook_sheet_add (wb, -1,
+				    GNM_DEFAULT_COLS, GNM_DEFAULT_ROWS);
+	workbook_set_recalcmode (wb, FALSE);
+
+	for (i = 0; i < 3; i++) {
+		char *txt = g_strdup_printf ("%d", i + 1);
+		sheet_cell_set_text (sheet_cell_fetch (sheet, 0, i), txt, NULL);
+		g_free (txt);
+	}
+	define_name ("Doubled", "TRANSPOSE($A$1:$A$3)*2", wb);
+	for (i = 0; i < 4; i++)
+		sheet_cell_set_text (sheet_cell_fetch (sheet, 1, i),
+				     "=SUM(Doubled)", NULL);
+
+	gnm_recalc_profile_set_enabled (TRUE);
+	gnm_recalc_profile_reset ();
+	workbook_recalc (wb);
+	gnm_recalc_profile_set_enabled (FALSE);
+	dump_cell (sheet, "B1", 1, 0);
+	dump_cell (sheet, "B4", 1, 3);
+
+	filename = g_build_filename (g_get_tmp_dir (),
+				     "sstest-name-eval.csv", NULL);
+	if (gnm_recalc_profile_save (filename, NULL))
+		g_printerr ("TRANSPOSE calls = %lu\n",
+			    profile_func_count (filename, "transpose"));
+	else
+		g_printerr ("Failed to save profile.\n");
+	g_unlink (filename);
+	g_free (filename);
+	gnm_recalc_profile_reset ();
+
+	g_object_unref (wb);
+
+	mark_test_end (test_name);
+}
+
+#define RANGE_DEPS_N	200
+#define RANGE_DEPS_COLS	20
+#define RANGE_DEPS_ROWS	60
+#define RANGE_DEPS_COL	30	/* where the formulas go */
+
+typedef struct {
+	GnmRange ranges[RANGE_DEPS_N];
+	gboolean alive[RANGE_DEPS_N];
+	int	 seen[RANGE_DEPS_N];
+} RangeDepsTest;
+
+static void
+cb_range_deps_seen (GnmDependent *dep, RangeDepsTest *t)
+{
+	if (dependent_is_cell (dep)) {
+		GnmCell const *cell = GNM_DEP_TO_CELL (dep);
+		if (cell->pos.col == RANGE_DEPS_COL &&
+		    cell->pos.row < RANGE_DEPS_N)
+			t->seen[cell->pos.row]++;
+	}
+}
+
+/* Compare what the index finds for every cell with a linear scan.  */
+static int
+range_deps_mismatches (Sheet *sheet, RangeDepsTest *t)
+{
+	int col, row, i, res = 0;
+
+	for (row = 0; row < RANGE_DEPS_ROWS; row++)
+		for (col = 0; col < RANGE_DEPS_COLS; col++) {
+			memset (t->seen, 0, sizeof (t->seen));
+			cell_foreach_dep (sheet_cell_get (sheet, col, row),
+					  (DepFunc) cb_range_deps_seen, t);
+			for (i = 0; i < RANGE_DEPS_N; i++) {
+				int expected = t->alive[i] &&
+					range_contains (&t->ranges[i], col, row);
+				if (t->seen[i] != expected)
+					res++;
+			}
+		}
+	return res;
+}
+
+static void
+test_range_deps (void)
+{
+	Workbook *wb;
+	GRand *rand;
+	RangeDepsTest *t;
+	const char *test_name = "test_range_deps";
+	int i, batched;
+
+	mark_test_start (test_name);
+
+	wb = workbook_new ();
+	workbook_set_recalcmode (wb, FALSE);
+	t = g_new0 (RangeDepsTest, 1);
+
+	rand = g_rand_new_with_seed (42);
+	for (i = 0; i < RANGE_DEPS_N; i++) {
+		GnmRange *r = &t->ranges[i];
+		int c0 = g_rand_int_range (rand, 0, RANGE_DEPS_COLS - 1);
+		int r0 = g_rand_int_range (rand, 0, RANGE_DEPS_ROWS - 1);
+		int c1 = g_rand_int_range (rand, c0 + 1, RANGE_DEPS_COLS);
+		int r1 = g_rand_int_range (rand, r0 + 1, RANGE_DEPS_ROWS);
+		/* Some whole columns and rows, which are indexed apart */
+		switch (i % 10) {
+		case 0:
+			range_init (r, c0, 0, c1, GNM_DEFAULT_ROWS - 1);
+			break;
+		case 1:
+			range_init (r, 0, r0, GNM_DEFAULT_COLS - 1, r1);
+			break;
+		default:
+			range_init (r, c0, r0, c1, r1);
+		}
+	}
+	g_rand_free (rand);
+
+	for (batched = 0; batched <= 1; batched++) {
+		Sheet *sheet = workbook_sheet_add (wb, -1, GNM_DEFAULT_COLS,
+						   GNM_DEFAULT_ROWS);
+		int col, row;
+
+		for (row = 0; row < RANGE_DEPS_ROWS; row++)
+			for (col = 0; col < RANGE_DEPS_COLS; col++)
+				sheet_cell_set_text
+					(sheet_cell_fetch (sheet, col, row),
+					 "1", NULL);
+
+		if (batched)
+			dependents_batch_begin (wb);
+		for (i = 0; i < RANGE_DEPS_N; i++) {
+			GnmRange const *r = &t->ranges[i];
+			char const *ref = (i % 10 == 0)
+				? cols_name (r->start.col, r->end.col)
+				: (i % 10 == 1)
+				? rows_name (r->start.row, r->end.row)
+				: range_as_string (r);
+			char *txt = g_strdup_printf ("=SUM(%s)", ref);
+			sheet_cell_set_text
+				(sheet_cell_fetch (sheet, RANGE_DEPS_COL, i),
+				 txt, NULL);
+			g_free (txt);
+			t->alive[i] = TRUE;
+		}
+		if (batched)
+			g_printerr ("Batched, before removals: %d mismatches\n",
+				    range_deps_mismatches (sheet, t));
+
+		for (i = 0; i < RANGE_DEPS_N; i += 3) {
+			sheet_clear_region (sheet, RANGE_DEPS_COL, i,
+					    RANGE_DEPS_COL, i,
+					    CLEAR_VALUES, NULL);
+			t->alive[i] = FALSE;
+		}
+		if (batched) {
+			g_printerr ("Batched, after removals: %d mismatches\n",
+				    range_deps_mismatches (sheet, t));
+			dependents_batch_end (wb);
+		}
+
+		g_printerr ("%s: %d mismatches\n",
+			    batched ? "Batched, packed" : "Unbatched",
+			    range_deps_mismatches (sheet, t));
+	}
+
+	g_free (t);
+	g_object_unref (wb);
+
+	mark_test_end (test_name);
+}
+
 static void
 test_func_help (void)
 {
@@ -259,6 +577,10 @@ main (int argc, char const **argv)
 
 	MAYBE_DO ("test_insdel_rowcol_names") test_insdel_rowcol_names ();
 	MAYBE_DO ("test_func_help") test_func_help ();
+	MAYBE_DO ("test_recalc_deleted_precedent") test_recalc_deleted_precedent ();
+	MAYBE_DO ("test_cached_array_roundtrip") test_cached_array_roundtrip ();
+	MAYBE_DO ("test_name_eval_once") test_name_eval_once ();
+	MAYBE_DO ("test_range_deps") test_range_deps ();
 
 	/* ---------------------------------------- */
 
@@ -1184,7 +1184,7 @@ stf_parse_options_fixed_autodiscover (StfParseOptions_t *parseoptions,
  */
 
 static void
-stf_cell_set_text (GnmCell *cell, char const *text)
+stf_cell_set_text (GnmCellLoader *loader, GnmCell *cell, char const *text)
 {
 	GnmExprTop const *texpr;
 	GnmValue *val;
@@ -1212,7 +1212,7 @@ stf_cell_set_text (GnmCell *cell, char const *text)
 	if (val)
 		gnm_cell_set_value (cell, val);
 	else {
-		gnm_cell_set_expr (cell, texpr);
+		gnm_cell_loader_set_expr (loader, cell, texpr, NULL);
 		gnm_expr_top_unref (texpr);
 	}
 }
@@ -1246,6 +1246,7 @@ stf_parse_sheet (StfParseOptions_t *parseoptions,
 	GODateConventions const *date_conv;
 	GStringChunk *lines_chunk;
 	GPtrArray *lines;
+	GnmCellLoader *loader;
 	gboolean result = TRUE;
 	int col;
 	unsigned int lcol;
@@ -1266,6 +1267,15 @@ stf_parse_sheet (StfParseOptions_t *parseoptions,
 	if (lines == NULL)
 		result = FALSE;
 
+	loader = gnm_cell_loader_new (sheet);
+	if (lines != NULL) {
+		guint n_cells = 0;
+		for (lrow = 0; lrow < lines->len; lrow++) {
+			GPtrArray *line = g_ptr_array_index (lines, lrow);
+			n_cells += line->len;
+		}
+		gnm_cell_loader_set_size_hint (loader, n_cells);
+	}
 	START_LOCALE_SWITCH;
 	for (row = start_row, lrow = 0;
 	     result && lrow < lines->len;
@@ -1307,7 +1317,7 @@ stf_parse_sheet (StfParseOptions_t *parseoptions,
 				char const *text = g_ptr_array_index (line, lcol);
 				if (text && *text) {
 					GnmCell *cell = sheet_cell_fetch (sheet, col, row);
-					stf_cell_set_text (cell, text);
+					stf_cell_set_text (loader, cell, text);
 				}
 			}
 			col++;
@@ -1317,6 +1327,7 @@ stf_parse_sheet (StfParseOptions_t *parseoptions,
 		g_ptr_array_free (line, TRUE);
 	}
 	END_LOCALE_SWITCH;
+	gnm_cell_loader_finish (loader);
 
 	for (lcol = 0, col = start_col;
 	     lcol < parseoptions->col_import_array_len  && col < gnm_sheet_get_max_cols (sheet);
@@ -33,6 +33,8 @@
 #include "search.h"
 #include "ranges.h"
 #include "cell.h"
+#include "dependent.h"
+#include "recalc-profile.h"
 #include "stf.h"
 #include "value.h"
 #include "gnm-format.h"
@@ -681,11 +683,21 @@ static GNM_ACTION_DEF (cb_edit_goto)
 static GNM_ACTION_DEF (cb_edit_recalc)
 {
 	/* TODO :
-	 * f9  -  do any necessary calculations across all sheets
 	 * shift-f9  -  do any necessary calcs on current sheet only
-	 * ctrl-alt-f9 -  force a full recalc across all sheets
 	 * ctrl-alt-shift-f9  -  a full-monty super recalc
 	 */
+	Workbook *wb = wb_control_get_workbook (WORKBOOK_CONTROL (wbcg));
+
+	/* In automatic mode only the volatile functions can be stale.  */
+	if (workbook_get_recalcmode (wb)) {
+		workbook_queue_volatile_recalc (wb);
+		workbook_recalc_incremental (wb);
+	} else
+		workbook_recalc_all (wb);
+}
+
+static GNM_ACTION_DEF (cb_edit_recalc_all)
+{
 	workbook_recalc_all (wb_control_get_workbook (WORKBOOK_CONTROL (wbcg)));
 }
 
@@ -941,6 +953,81 @@ static GNM_ACTION_DEF (cb_tools_solver)
 #endif
 }
 
+static GNM_ACTION_DEF (cb_tools_find_cycles)
+{
+	Workbook *wb = wb_control_get_workbook (WORKBOOK_CONTROL (wbcg));
+	GSList *cycles = workbook_find_cycles (wb), *ptr;
+	GString *msg;
+
+	if (cycles == NULL) {
+		go_gtk_notice_dialog (wbcg_toplevel (wbcg), GTK_MESSAGE_INFO,
+				      _("There are no circular references."));
+		return;
+	}
+
+	msg = g_string_new (NULL);
+	g_string_printf (msg, ngettext ("There is %d circular reference:",
+					"There are %d circular references:",
+					g_slist_length (cycles)),
+			 g_slist_length (cycles));
+	for (ptr = cycles; ptr != NULL; ptr = ptr->next) {
+		GPtrArray *cells = ptr->data;
+		guint i;
+
+		g_string_append (msg, "\n");
+		for (i = 0; i < cells->len && i < 10; i++) {
+			GnmCell const *cell = g_ptr_array_index (cells, i);
+			g_string_append_printf (msg, "%s%s!%s", i ? ", " : "",
+						cell->base.sheet->name_quoted,
+						cell_name (cell));
+		}
+		if (i < cells->len)
+			g_string_append (msg, ", ...");
+		g_ptr_array_free (cells, TRUE);
+	}
+	g_slist_free (cycles);
+
+	go_gtk_notice_dialog (wbcg_toplevel (wbcg), GTK_MESSAGE_WARNING,
+			      "%s", msg->str);
+	g_string_free (msg, TRUE);
+}
+
+static GNM_ACTION_DEF (cb_tools_profile_recalc)
+{
+	gnm_recalc_profile_set_enabled
+		(gtk_toggle_action_get_active (GTK_TOGGLE_ACTION (a)));
+}
+
+static GNM_ACTION_DEF (cb_tools_profile_recalc_save)
+{
+	GtkFileChooser *fsel = GTK_FILE_CHOOSER
+		(g_object_new (GTK_TYPE_FILE_CHOOSER_DIALOG,
+			       "action", GTK_FILE_CHOOSER_ACTION_SAVE,
+			       "title", _("Save Recalculation Profile"),
+			       "local-only", TRUE,
+			       NULL));
+	gtk_dialog_add_buttons (GTK_DIALOG (fsel),
+				GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+				GTK_STOCK_SAVE, GTK_RESPONSE_OK,
+				NULL);
+	gtk_dialog_set_default_response (GTK_DIALOG (fsel), GTK_RESPONSE_OK);
+	gtk_file_chooser_set_current_name (fsel, "recalc-profile.csv");
+
+	if (go_gtk_file_sel_dialog (wbcg_toplevel (wbcg), GTK_WIDGET (fsel))) {
+		char *filename = gtk_file_chooser_get_filename (fsel);
+		GError *err = NULL;
+
+		if (!gnm_recalc_profile_save (filename, &err)) {
+			go_gtk_notice_dialog (wbcg_toplevel (wbcg),
+					      GTK_MESSAGE_ERROR,
+					      "%s", err->message);
+			g_error_free (err);
+		}
+		g_free (filename);
+	}
+	gtk_widget_destroy (GTK_WIDGET (fsel));
+}
+
 static GNM_ACTION_DEF (cb_tools_scenario_add)	{ dialog_scenario_add (wbcg); }
 static GNM_ACTION_DEF (cb_tools_scenarios)	{ dialog_scenarios (wbcg); }
 static GNM_ACTION_DEF (cb_tools_simulation)	{ dialog_simulation (wbcg, wbcg_cur_sheet (wbcg)); }
@@ -2208,6 +2295,9 @@ static GtkActionEntry const actions[] = {
 	{ "EditRecalc", NULL, N_("Recalculate"),
 		"F9", N_("Recalculate the spreadsheet"),
 		G_CALLBACK (cb_edit_recalc) },
+	{ "EditRecalcAll", NULL, N_("Recalculate _All"),
+		"<control><alt>F9", N_("Recalculate every formula in the spreadsheet"),
+		G_CALLBACK (cb_edit_recalc_all) },
 
 	{ "EditPreferences", GTK_STOCK_PREFERENCES, N_("Preferences..."),
 		NULL, N_("Change Gnumeric Preferences"),
@@ -2346,6 +2436,12 @@ static GtkActionEntry const actions[] = {
 		G_CALLBACK (cb_format_row_std_height) },
 
 /* Tools */
+	{ "ToolsFindCycles", NULL, N_("Find C_ircular References..."),
+		NULL, N_("List the cells that depend on themselves"),
+		G_CALLBACK (cb_tools_find_cycles) },
+	{ "ToolsProfileRecalcSave", NULL, N_("Save Recalculation Profile..."),
+		NULL, N_("Write the recalculation times collected so far to a CSV or JSON file"),
+		G_CALLBACK (cb_tools_profile_recalc_save) },
 	{ "ToolsPlugins", NULL, N_("_Plug-ins..."),
 		NULL, N_("Manage available plugin modules"),
 		G_CALLBACK (cb_tools_plugins) },
@@ -2786,6 +2882,11 @@ static GtkToggleActionEntry const toggle_actions[] = {
 		N_("Align _Bottom"), NULL,
 		N_("Align Bottom"), G_CALLBACK (cb_align_bottom), FALSE },
 
+	{ "ToolsProfileRecalc", NULL,
+		N_("_Profile Recalculation"), NULL,
+		N_("Record the time spent evaluating each cell and function"),
+		G_CALLBACK (cb_tools_profile_recalc), FALSE },
+
 	{ "ViewStatusbar", NULL,
 		N_("View _Statusbar"), NULL,
 		N_("Toggle visibility of statusbar"),
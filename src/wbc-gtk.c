@@ -2227,6 +2227,9 @@ cb_workbook_debug_info (WBCGtk *wbcg)
 		dependents_dump (wb);
 	}
 
+	if (gnm_debug_flag ("dep-stats"))
+		dependents_dump_stats (wb);
+
 	if (gnm_debug_flag ("expr-sharer")) {
 		GnmExprSharer *es = workbook_share_expressions (wb, FALSE);
 
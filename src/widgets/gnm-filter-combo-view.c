@@ -162,6 +162,9 @@ fcombo_create_list (SheetObject *so,
 	GnmValue const *v;
 	GnmValue const *cur_val = NULL;
 
+	/* The list shows the current values of the column.  */
+	workbook_recalc_flush (filter->sheet->workbook);
+
 	model = gtk_list_store_new (4,
 		G_TYPE_STRING, G_TYPE_STRING, G_TYPE_INT, gnm_value_get_type ());
 
@@ -35,6 +35,7 @@ struct _Workbook {
 		double   tolerance;
 	} iteration;
 	gboolean recalc_auto;
+	guint	 recalc_idle;	/* incremental recalc in progress */
 	GODateConventions const *date_conv;
 
 	gboolean during_destruction;
@@ -69,8 +70,8 @@ do {										\
 		WORKBOOK_VIEW_FOREACH_CONTROL(view, control, code);)
 
 /*
- * Walk the dependents.  WARNING: Note, that it is only valid to muck with
- * the current dependency in the code.
+ * Walk the dependents.  WARNING: Note, that the code must not link or
+ * unlink dependents, use WORKBOOK_FOREACH_DEPENDENT_SAFE for that.
  */
 #define WORKBOOK_FOREACH_DEPENDENT(wb, dep, code)			\
   do {									\
@@ -81,6 +82,13 @@ do {										\
 	});								\
   } while (0)
 
+#define WORKBOOK_FOREACH_DEPENDENT_SAFE(wb, dep, code)			\
+  do {									\
+	WORKBOOK_FOREACH_SHEET(wb, _wfd_sheet, {			\
+		SHEET_FOREACH_DEPENDENT_SAFE (_wfd_sheet, dep, code);	\
+	});								\
+  } while (0)
+
 G_END_DECLS
 
 #endif /* _GNM_WORKBOOK_PRIV_H_ */
@@ -45,6 +45,7 @@
 #include "gnm-sheet-slicer-combo.h"
 #include "position.h"
 #include "cell.h"
+#include "dependent.h"
 #include "gutils.h"
 #include "command-context.h"
 #include "auto-format.h"
@@ -1044,6 +1045,8 @@ wbv_save_to_output (WorkbookView *wbv, GOFileSaver const *fs,
 	char const   *msg;
 	GODoc *godoc = wb_view_get_doc (wbv);
 
+	workbook_recalc_flush (wb_view_get_workbook (wbv));
+
 	if (go_doc_is_dirty (godoc))
 	  /* FIXME: we should be using the true modification time */
 	  gnm_insert_meta_date (godoc, GSF_META_NAME_DATE_MODIFIED);
@@ -1193,6 +1196,22 @@ wb_view_save (WorkbookView *wbv, GOCmdContext *context)
 	return !has_error;
 }
 
+static gboolean recalc_after_load = TRUE;
+
+/**
+ * wb_view_set_recalc_after_load :
+ * @recalc :
+ *
+ * Whether wb_view_new_from_input computes the dirty cells of the workbooks
+ * it loads.  Callers that turn this off are responsible for computing
+ * what they look at, see workbook_recalc_cone.
+ **/
+void
+wb_view_set_recalc_after_load (gboolean recalc)
+{
+	recalc_after_load = recalc;
+}
+
 WorkbookView *
 wb_view_new_from_input (GsfInput *input,
 			const char *optional_uri,
@@ -1268,7 +1287,9 @@ wb_view_new_from_input (GsfInput *input,
 		} else {
 			workbook_share_expressions (new_wb, TRUE);
 			workbook_optimize_style (new_wb);
-			workbook_recalc (new_wb);
+			dependents_compact (new_wb);
+			if (recalc_after_load)
+				workbook_recalc (new_wb);
 			go_doc_set_dirty (GO_DOC (new_wb), FALSE);
 		}
 	} else
@@ -101,6 +101,7 @@ WorkbookView *wb_view_new_from_uri  (char const *uri,
 				     GOFileOpener const *optional_format,
 				     GOIOContext *io_context,
 				     gchar const *optional_encoding);
+void	 wb_view_set_recalc_after_load (gboolean recalc);
 
 #define WORKBOOK_VIEW_FOREACH_CONTROL(wbv, control, code)			\
 do {										\
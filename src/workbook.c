@@ -183,6 +183,7 @@ workbook_init (GObject *object)
 	wb->iteration.max_number = 100;
 	wb->iteration.tolerance = .001;
 	wb->recalc_auto = TRUE;
+	wb->recalc_idle = 0;
 
 	workbook_set_1904 (wb, FALSE);
 
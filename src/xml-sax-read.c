@@ -42,6 +42,7 @@
 #include "hlink.h"
 #include "input-msg.h"
 #include "cell.h"
+#include "dependent.h"
 #include "position.h"
 #include "expr.h"
 #include "expr-name.h"
@@ -342,6 +343,11 @@ typedef struct {
 	int expr_id, array_rows, array_cols;
 	int value_type;
 	GOFormat *value_fmt;
+	int cached_type;
+	char *cached_str;
+	GOFormat *cached_fmt;
+	gboolean used_cached_values;
+	GnmCellLoader *loader;
 
 	GnmScenario *scenario;
 	GnmValue *scenario_range;
@@ -757,6 +763,9 @@ xml_sax_sheet_end (GsfXMLIn *xin, G_GNUC_UNUSED GsfXMLBlob *blob)
 
 	xml_sax_must_have_sheet (state);
 
+	gnm_cell_loader_finish (state->loader);
+	state->loader = NULL;
+
 	/* Init ColRowInfo's size_pixels and force a full respan */
 	g_object_set (state->sheet, "zoom-factor", state->sheet_zoom, NULL);
 	sheet_flag_recompute_spans (state->sheet);
@@ -1338,6 +1347,10 @@ xml_sax_colrow (GsfXMLIn *xin, xmlChar const **attrs)
 	cri->visible = !hidden;
 	cri->is_collapsed = is_collapsed;
 	cri->outline_level = outline_level;
+	/* The copies below do not go through the size setters.  */
+	colrow_sizes_changed (is_col
+			      ? &state->sheet->cols
+			      : &state->sheet->rows, pos);
 
 	if (is_col) {
 		sheet_col_set_size_pts (state->sheet, pos, size, cri->hard_size);
@@ -1812,6 +1825,16 @@ xml_sax_style_border (GsfXMLIn *xin, xmlChar const **attrs)
 	}
 }
 
+static void
+xml_sax_cell_clear_cached (XMLSaxParseState *state)
+{
+	state->cached_type = -1;
+	g_free (state->cached_str);
+	state->cached_str = NULL;
+	go_format_unref (state->cached_fmt);
+	state->cached_fmt = NULL;
+}
+
 static void
 xml_sax_cell (GsfXMLIn *xin, xmlChar const **attrs)
 {
@@ -1831,6 +1854,8 @@ xml_sax_cell (GsfXMLIn *xin, xmlChar const **attrs)
 	g_return_if_fail (state->expr_id == -1);
 	g_return_if_fail (state->value_type == -1);
 
+	xml_sax_cell_clear_cached (state);
+
 	for (; attrs != NULL && attrs[0] && attrs[1] ; attrs += 2) {
 		if (gnm_xml_attr_int (attrs, "Col", &col)) ;
 		else if (gnm_xml_attr_int (attrs, "Row", &row)) ;
@@ -1840,7 +1865,14 @@ xml_sax_cell (GsfXMLIn *xin, xmlChar const **attrs)
 		else if (gnm_xml_attr_int (attrs, "ValueType", &value_type)) ;
 		else if (attr_eq (attrs[0], "ValueFormat"))
 			value_fmt = make_format (CXML2C (attrs[1]));
-		else
+		else if (gnm_xml_attr_int (attrs, "CachedType", &state->cached_type)) ;
+		else if (attr_eq (attrs[0], "CachedValue")) {
+			g_free (state->cached_str);
+			state->cached_str = g_strdup (CXML2C (attrs[1]));
+		} else if (attr_eq (attrs[0], "CachedFormat")) {
+			go_format_unref (state->cached_fmt);
+			state->cached_fmt = make_format (CXML2C (attrs[1]));
+		} else
 			unknown_attr (xin, attrs);
 	}
 
@@ -1865,6 +1897,31 @@ xml_sax_cell (GsfXMLIn *xin, xmlChar const **attrs)
 	state->value_fmt = value_fmt;
 }
 
+/*
+ * Store @texpr in @cell.  If the file recorded the value the expression had
+ * when it was saved, use it and leave the cell clean, otherwise queue the
+ * cell for recalc.
+ */
+static void
+xml_cell_set_expr (XMLSaxParseState *state,
+		   GnmCell *cell, GnmExprTop const *texpr)
+{
+	GnmValue *v = NULL;
+
+	if (state->cached_type > 0 && state->cached_str != NULL)
+		v = value_new_from_string (state->cached_type,
+					   state->cached_str,
+					   state->cached_fmt, FALSE);
+
+	if (v != NULL)
+		state->used_cached_values = TRUE;
+
+	/* Linked in one go at the end of the sheet */
+	if (state->loader == NULL)
+		state->loader = gnm_cell_loader_new (cell->base.sheet);
+	gnm_cell_loader_set_expr (state->loader, cell, texpr, v);
+}
+
 /**
  * xml_cell_set_array_expr : Utility routine to parse an expression
  *     and store it as an array.
@@ -1901,6 +1958,10 @@ xml_cell_set_array_expr (XMLSaxParseState *state,
 
 	if (!gnm_cell_set_array (cell->base.sheet, &r, texpr)) {
 		xml_sax_barf (G_STRFUNC, "target area empty");
+	} else {
+		/* Array results are not saved.  Files with cached values
+		 * only queue volatile cells, so queue the array here.  */
+		dependent_queue_recalc (GNM_CELL_TO_DEP (cell));
 	}
 
 	gnm_expr_top_unref (texpr);
@@ -2049,7 +2110,7 @@ xml_sax_cell_content (GsfXMLIn *xin, G_GNUC_UNUSED GsfXMLBlob *blob)
 								    state->convs,
 								    &perr);
 					if (texpr && cell) {
-						gnm_cell_set_expr (cell, texpr);
+						xml_cell_set_expr (state, cell, texpr);
 						gnm_expr_top_unref (texpr);
 					} else if (texpr)
 						cc->texpr = texpr;
@@ -2103,7 +2164,7 @@ xml_sax_cell_content (GsfXMLIn *xin, G_GNUC_UNUSED GsfXMLBlob *blob)
 		}
 
 		if (cell)
-			gnm_cell_set_expr (cell, texpr);
+			xml_cell_set_expr (state, cell, texpr);
 		else {
 			cc->texpr = texpr;
 			gnm_expr_top_ref (texpr);
@@ -3152,6 +3213,11 @@ read_file_init_state (XMLSaxParseState *state,
 	state->expr_id = -1;
 	state->value_type = -1;
 	state->value_fmt = NULL;
+	state->cached_type = -1;
+	state->cached_str = NULL;
+	state->cached_fmt = NULL;
+	state->used_cached_values = FALSE;
+	state->loader = NULL;
 	state->scenario = NULL;
 	state->scenario_range = NULL;
 	state->filter = NULL;
@@ -3174,6 +3240,9 @@ read_file_init_state (XMLSaxParseState *state,
 static void
 read_file_free_state (XMLSaxParseState *state, gboolean self)
 {
+	xml_sax_cell_clear_cached (state);
+	gnm_cell_loader_finish (state->loader);
+	state->loader = NULL;
 	g_hash_table_destroy (state->expr_map);
 	state->expr_map = NULL;
 
@@ -3392,7 +3461,11 @@ gnm_xml_file_open (GOFileOpener const *fo, GOIOContext *io_context,
 	g_object_unref (input);
 
 	if (ok) {
-		workbook_queue_all_recalc (state.wb);
+		/* Cells without a saved value were queued as they were read */
+		if (state.used_cached_values)
+			workbook_queue_volatile_recalc (state.wb);
+		else
+			workbook_queue_all_recalc (state.wb);
 
 		workbook_set_saveinfo
 			(state.wb,
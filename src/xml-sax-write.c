@@ -805,10 +805,14 @@ xml_write_selection_info (GnmOutputXML *state)
 	gsf_xml_out_end_element (state->output); /* </gnm:Selections> */
 }
 
+/*
+ * @cached : for expressions, the last computed value or NULL.  Saving it
+ * lets the reader display the result without a recalc.
+ */
 static void
 xml_write_cell_and_position (GnmOutputXML *state,
 			     GnmExprTop const *texpr, GnmValue const *val,
-			     GnmParsePos const *pp)
+			     GnmValue const *cached, GnmParsePos const *pp)
 {
 	gboolean write_contents = TRUE;
 	gboolean const is_shared_expr = (texpr != NULL) &&
@@ -842,6 +846,20 @@ xml_write_cell_and_position (GnmOutputXML *state,
 		gsf_xml_out_add_int (state->output, "Cols", texpr->expr->array_corner.cols);
 	}
 
+	/* As of 1.10.18 we save the last value of an expression */
+	if (texpr && cached) {
+		GString *str = state->cell_str;
+
+		g_string_truncate (str, 0);
+		value_get_as_gstring (cached, str, state->convs);
+		gsf_xml_out_add_int (state->output, "CachedType", cached->type);
+		if (VALUE_FMT (cached) != NULL) {
+			const char *fmt = go_format_as_XL (VALUE_FMT (cached));
+			gsf_xml_out_add_cstr (state->output, "CachedFormat", fmt);
+		}
+		gsf_xml_out_add_cstr (state->output, "CachedValue", str->str);
+	}
+
 	if (write_contents) {
 		GString *str = state->cell_str;
 
@@ -876,8 +894,32 @@ xml_write_cell_and_position (GnmOutputXML *state,
 static GnmValue *
 cb_write_cell (GnmCellIter const *iter, GnmOutputXML *state)
 {
+	GnmCell const *cell = iter->cell;
+	GnmValue const *cached = NULL;
+
+	/* Array results are regenerated from the corner, anything that is
+	 * still dirty is not worth keeping, and dynamic dependencies are
+	 * only discovered by evaluating.  */
+	if (gnm_cell_has_expr (cell) &&
+	    !gnm_cell_needs_recalc (cell) &&
+	    !(cell->base.flags & DEPENDENT_HAS_DYNAMIC_DEPS) &&
+	    !gnm_cell_is_array (cell) &&
+	    cell->value != NULL) {
+		switch (cell->value->type) {
+		case VALUE_EMPTY:
+		case VALUE_BOOLEAN:
+		case VALUE_FLOAT:
+		case VALUE_ERROR:
+		case VALUE_STRING:
+			cached = cell->value;
+			break;
+		default:
+			break;
+		}
+	}
+
 	xml_write_cell_and_position (state,
-		iter->cell->base.texpr, iter->cell->value, &iter->pp);
+		cell->base.texpr, cell->value, cached, &iter->pp);
 	return NULL;
 }
 
@@ -1471,7 +1513,7 @@ cb_xml_write_cell_region_cells (GnmCellCopy *cc, gconstpointer ignore,
 	state->pp.eval.col = state->cr->base.col + cc->offset.col;
 	state->pp.eval.row = state->cr->base.row + cc->offset.row;
 	xml_write_cell_and_position (&state->state,
-		cc->texpr, cc->val, &state->pp);
+		cc->texpr, cc->val, NULL, &state->pp);
 }
 
 /**
@@ -0,0 +1,23 @@
+#!/usr/bin/perl -w
+# -----------------------------------------------------------------------------
+
+use strict;
+use lib ($0 =~ m|^(.*/)| ? $1 : ".");
+use GnumericTest;
+
+my $expected;
+{ local $/; $expected = <DATA>; }
+
+&message ("Check that deleting a dirty cell recalculates its dependents.");
+&sstest ("test_recalc_deleted_precedent", $expected);
+
+__DATA__
+-----------------------------------------------------------------------------
+Start: test_recalc_deleted_precedent
+-----------------------------------------------------------------------------
+
+C1 = 3
+Changing A1 without recalc, then deleting B1.
+B1 = (empty)
+C1 = 1
+End: test_recalc_deleted_precedent
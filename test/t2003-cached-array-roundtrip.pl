@@ -0,0 +1,26 @@
+#!/usr/bin/perl -w
+# -----------------------------------------------------------------------------
+
+use strict;
+use lib ($0 =~ m|^(.*/)| ? $1 : ".");
+use GnumericTest;
+
+my $expected;
+{ local $/; $expected = <DATA>; }
+
+&message ("Check that arrays are recalculated in files with cached values.");
+&sstest ("test_cached_array_roundtrip", $expected);
+
+__DATA__
+-----------------------------------------------------------------------------
+Start: test_cached_array_roundtrip
+-----------------------------------------------------------------------------
+
+B1 = 6
+C1 = 3
+D1 = 6
+Saving with cached values and loading again.
+B1 = 6
+C1 = 3
+D1 = 6
+End: test_cached_array_roundtrip
@@ -0,0 +1,22 @@
+#!/usr/bin/perl -w
+# -----------------------------------------------------------------------------
+
+use strict;
+use lib ($0 =~ m|^(.*/)| ? $1 : ".");
+use GnumericTest;
+
+my $expected;
+{ local $/; $expected = <DATA>; }
+
+&message ("Check that a name computing an array is evaluated once per recalc.");
+&sstest ("test_name_eval_once", $expected);
+
+__DATA__
+-----------------------------------------------------------------------------
+Start: test_name_eval_once
+-----------------------------------------------------------------------------
+
+B1 = 12
+B4 = 12
+TRANSPOSE calls = 1
+End: test_name_eval_once
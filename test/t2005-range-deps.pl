@@ -0,0 +1,23 @@
+#!/usr/bin/perl -w
+# -----------------------------------------------------------------------------
+
+use strict;
+use lib ($0 =~ m|^(.*/)| ? $1 : ".");
+use GnumericTest;
+
+my $expected;
+{ local $/; $expected = <DATA>; }
+
+&message ("Check range dependency lookups with and without a batch.");
+&sstest ("test_range_deps", $expected);
+
+__DATA__
+-----------------------------------------------------------------------------
+Start: test_range_deps
+-----------------------------------------------------------------------------
+
+Unbatched: 0 mismatches
+Batched, before removals: 0 mismatches
+Batched, after removals: 0 mismatches
+Batched, packed: 0 mismatches
+End: test_range_deps